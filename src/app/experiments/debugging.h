@@ -1,13 +1,20 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <filesystem>
 #include <iostream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #include "app/db_factory.h"
 #include "app/experiments/i_experiment.h"
 
 #include "schemes/interfaces/sse.h"
+#include "schemes/log_src_i/log_src_i_base.h"
+#include "schemes/multi_attr/multi_attr.h"
 
 #include "utils/crypto.h"
 #include "utils/types/basic_types.h"
@@ -28,6 +35,24 @@ public:
         // calls to `run()`, for different SSE schemes
         createDb(this->db, std::pow(2, dbSizeExp), true, true);
         this->query = Range<Kw> {3, 5};
+        // (overlapping, repeated and deleted points to exercise the sharing of work in
+        // `searchBatch()`)
+        Kw maxKw = this->db.size() - 1;
+        this->batchQueries = {
+            this->query, Range<Kw> {0, maxKw / 2}, Range<Kw> {4, 4}, Range<Kw> {maxKw, maxKw},
+            this->query
+        };
+
+        // two attributes over the same ids (with independently random values), queried with a
+        // range on both and with the second one left unfiltered
+        bigint dbSize = std::pow(2, dbSizeExp);
+        this->attrDbs.resize(2);
+        createDb(this->attrDbs[0], dbSize, true, false);
+        createDb(this->attrDbs[1], dbSize, true, false);
+        this->multiAttrQueries = {
+            {Range<Kw> {dbSize / 4, dbSize / 2}, Range<Kw> {dbSize / 8, dbSize * 3 / 4}},
+            {Range<Kw> {dbSize / 4, dbSize / 2}, Range<Kw>::DUMMY()}
+        };
     }
 
     void printHeader() const override {
@@ -66,18 +91,139 @@ public:
         }
         std::cout << std::endl;
 
+        // check that searching the batch queries together gives the same results as one by one
+        std::vector<std::vector<Tuple<>>> batchResults = sse->searchBatch(this->batchQueries);
+        if (batchResults.size() != this->batchQueries.size()) {
+            std::cout << "Search batch: MISMATCH (" << batchResults.size() << " result lists for "
+                      << this->batchQueries.size() << " queries)" << std::endl;
+        } else {
+            bool isBatchOk = true;
+            for (bigint i = 0; i < (bigint)this->batchQueries.size(); i++) {
+                std::vector<Tuple<>> seqResults = sse->search(this->batchQueries[i]);
+                if (toSortedDocs(batchResults[i]) != toSortedDocs(seqResults)) {
+                    std::cout << "Search batch: MISMATCH for query " << this->batchQueries[i]
+                              << " (" << batchResults[i].size() << " batch results, "
+                              << seqResults.size() << " sequential)" << std::endl;
+                    isBatchOk = false;
+                }
+            }
+            if (isBatchOk) {
+                std::cout << "Search batch: OK" << std::endl;
+            }
+        }
+        std::cout << std::endl;
+
         sse->clear();
     }
 
+    /**
+     * set up `sse`, save it, open it into a fresh `Sse` and check that the fresh one returns the
+     * same results (to exercise the validation of saved index file headers and their reopening).
+     */
+    template <class Sse> requires IsSse<Sse>
+    void runSaveOpen(Sse* sse) const {
+        const std::string dir = "out/debugging_saved";
+
+        sse->setup(utils::crypto::KEY_LEN, this->db);
+        std::vector<Tuple<>> results = sse->search(this->query);
+        sse->save(dir);
+
+        Sse openedSse(sse->benchmark);
+        openedSse.open(dir);
+        std::vector<Tuple<>> openedResults = openedSse.search(this->query);
+        if (toSortedDocs(openedResults) == toSortedDocs(results)) {
+            std::cout << "Save/open: OK" << std::endl;
+        } else {
+            std::cout << "Save/open: MISMATCH (" << results.size() << " results before saving, "
+                      << openedResults.size() << " after opening)" << std::endl;
+        }
+        std::cout << std::endl;
+
+        // (saved index files aren't deleted by `clear()`)
+        openedSse.clear();
+        sse->clear();
+        std::filesystem::remove_all(dir);
+    }
+
+    /**
+     * set up `multiAttr` over the two attribute DBs and check its conjunctive and disjunctive
+     * results against a plaintext scan of those DBs.
+     */
+    template <IsLogSrcI AttrSse>
+    void runMultiAttr(MultiAttr<AttrSse>* multiAttr) const {
+        multiAttr->setup(utils::crypto::KEY_LEN, this->attrDbs);
+
+        for (const std::vector<Range<Kw>>& query : this->multiAttrQueries) {
+            // number of (filtered) attributes each id matches
+            std::unordered_map<Id, bigint> matchCounts;
+            bigint filteredAttrCount = 0;
+            for (bigint attr = 0; attr < (bigint)query.size(); attr++) {
+                if (Range<Kw>::isDummy(query[attr])) {
+                    continue;
+                }
+                filteredAttrCount++;
+                for (const Tuple<>& tuple : this->attrDbs[attr]) {
+                    if (query[attr].contains(tuple.getKw())) {
+                        matchCounts[tuple.getId()]++;
+                    }
+                }
+            }
+
+            for (bool isConjunctive : {true, false}) {
+                std::vector<Id> expectedIds;
+                for (const auto& [id, matchCount] : matchCounts) {
+                    if (!isConjunctive || matchCount == filteredAttrCount) {
+                        expectedIds.push_back(id);
+                    }
+                }
+                std::sort(expectedIds.begin(), expectedIds.end());
+
+                std::vector<Id> ids = multiAttr->search(query, isConjunctive);
+                std::cout << (isConjunctive ? "Conjunctive" : "Disjunctive") << " query";
+                for (const Range<Kw>& attrQuery : query) {
+                    std::cout << " " << attrQuery;
+                }
+                if (ids == expectedIds) {
+                    std::cout << ": OK (" << ids.size() << " results)" << std::endl;
+                } else {
+                    std::cout << ": MISMATCH (" << ids.size() << " results, expected "
+                              << expectedIds.size() << ")" << std::endl;
+                }
+            }
+        }
+        std::cout << std::endl;
+
+        multiAttr->clear();
+    }
+
     // to free memory
     void clearDb() {
         this->db.clear();
+        this->attrDbs.clear();
     }
 
 private:
     bigint dbSizeExp;
     Db<> db;
     Range<Kw> query;
+    std::vector<Range<Kw>> batchQueries;
+    std::vector<Db<>> attrDbs;
+    std::vector<std::vector<Range<Kw>>> multiAttrQueries;
+
+    /**
+     * returns: the documents in `results`, sorted and without duplicates (so that results can be
+     * compared regardless of the order they came back in).
+     */
+    static std::vector<std::tuple<Id, Kw, Op>> toSortedDocs(const std::vector<Tuple<>>& results) {
+        std::vector<std::tuple<Id, Kw, Op>> docs;
+        docs.reserve(results.size());
+        for (const Tuple<>& result : results) {
+            docs.push_back(result.getDbDoc());
+        }
+        std::sort(docs.begin(), docs.end());
+        docs.erase(std::unique(docs.begin(), docs.end()), docs.end());
+        return docs;
+    }
 };
 
 
@@ -33,6 +33,76 @@ inline constexpr bool SHOULD_STORE_DBS_ON_DISK = false;
 // i find that 2^8 is a pretty good balance
 inline constexpr bigint ENC_IND_READ_BUF_CAPACITY = std::pow(2, 8);
 
+// set this to `true` to pad each NLogN bucket (on levels with buckets at least a page long) to a
+// 4 KiB boundary and read whole buckets with `O_DIRECT`, bypassing the page cache
+// (more predictable bandwidth for large levels, at the cost of some padding in server storage)
+inline constexpr bool SHOULD_USE_DIRECT_IO_FOR_ENC_IND_LOCS = false;
+
+// set this to `true` to serve encrypted indexes reopened with `ISse::open()` straight out of a
+// read-only `mmap()` of their files, so search is ready right after startup and several server
+// processes opening the same index share one page cache copy (instead of reading with `pread()`)
+inline constexpr bool SHOULD_MMAP_OPENED_ENC_INDS = true;
+
+// set this to `true` to fault in every page of a mapped encrypted index when it is opened
+// (`MAP_POPULATE`), trading slower startup for no page faults during search;
+// otherwise pages are only read in when a search first touches them
+inline constexpr bool SHOULD_POPULATE_MMAPED_ENC_INDS = false;
+
+// max number of emptied encrypted index files to keep open for reuse by later `init()`s instead of
+// deleting them and creating new ones (e.g. SDa clears and rebuilds levels on every merge)
+// set this to `0` to always delete them
+inline constexpr bigint ENC_IND_FILE_POOL_CAPACITY = 64;
+
+// max number of reads/writes in flight at once for batched encrypted index I/O (`utils::async_io`)
+inline constexpr int ASYNC_IO_QUEUE_DEPTH = 64;
+
+// number of consecutive labels PiBas looks up at a time during search, so that the reads
+// for all of them can be issued together
+inline constexpr bigint PI_BAS_SEARCH_BATCH_SIZE = 16;
+
+// set this to `true` to have PiBas search fetch its next batches on a long-lived worker thread
+// while the client decrypts the ones already returned, once a search turns out to need more than
+// one batch (so e.g. Log-SRC-i's first round isn't the sum of all of its reads and all of its
+// decryptions); off by default since it hasn't been measured to beat fetching them in line yet
+inline constexpr bool SHOULD_PIPELINE_PI_BAS_SEARCH = false;
+
+// max number of fetched but not yet decrypted batches a pipelined PiBas search keeps at once
+inline constexpr bigint PI_BAS_SEARCH_PIPELINE_DEPTH = 8;
+
+// max number of decrypted results Log-SRC and Log-SRC-i(*) each keep cached on the client per
+// SRC node they search for (least recently used nodes are evicted first), so that repeated queries
+// covered by the same node don't go back to the server; the cache is emptied by `setup()` and
+// `clear()` (so also whenever SDa rebuilds or empties that subindex)
+// set this to `0` to turn the cache off
+inline constexpr bigint SRC_RESULTS_CACHE_CAPACITY = 0;
+
+// set this to `true` to use Robin Hood hashing (bounded probe lengths) instead of plain linear
+// probing for the pseudorandom encrypted indexes (PiBas and NLogN's keyword count dictionary)
+inline constexpr bool USE_ROBIN_HOOD_ENC_INDS = false;
+
+// set this to `true` to have `EncIndRand`s keep a one-byte fingerprint of each slot's key in RAM,
+// so that lookups only read slots whose fingerprint matches; a miss then only walks fingerprints
+// in RAM up to the first empty slot and reads just the ~1/255 of those slots that are false
+// positives (which needs `ENC_IND_LOAD_FACTOR` below `1`: with no empty slots, a miss walks every
+// fingerprint and reads ~n/255 slots)
+// this costs 1 byte of server RAM per slot of *every* pseudorandom index (PiBas, each SDa level's
+// PiBas, NLogN's keyword count dictionary), e.g. ~1 MiB per million slots at the default load
+// factor, plus the same amount again in each saved index file; fingerprints are only consulted
+// while an index has no tombstones (otherwise a miss couldn't stop at the first empty slot)
+inline constexpr bool SHOULD_KEEP_ENC_IND_FINGERPRINTS = false;
+
+// set this to `true` to have NLogN's server keep its whole keyword count dictionary (one small
+// entry per distinct keyword) in RAM once it's built or opened, so that the count lookup in front
+// of every NLogN search never has to go to disk
+inline constexpr bool SHOULD_KEEP_DB_KW_COUNTS_DICTS_IN_RAM = false;
+
+// fraction of slots that will be occupied in pseudorandom encrypted indexes after setup
+// (lower values trade server storage for shorter probes during setup and search)
+// this must be below `1` for lookups that miss (e.g. the end of every PiBas search) to stop at
+// the first empty slot; at `1`, which matches the papers' storage of exactly n entries, there are
+// no empty slots, so every miss has to scan the whole index
+inline constexpr double ENC_IND_LOAD_FACTOR = 0.75;
+
 
 //------------------------------------------------------------------------------
 // other
@@ -40,7 +110,8 @@ inline constexpr bigint ENC_IND_READ_BUF_CAPACITY = std::pow(2, 8);
 
 // this is the max number of decimal digits you want ids and keywords to be able to support
 // this is used to determine the size of each entry in encrypted indexes (see that file for details)
-// currently: 11 corresponds to each encrypted tuple taking 3 AES blocks (= 48 bytes)
+// currently: 11 corresponds to each encrypted `Tuple<>` taking 3 AES blocks (= 48 bytes), each
+// `SrcIDb1Tuple` taking 4 (= 64 bytes), and each encrypted count taking 1 (= 16 bytes)
 inline constexpr int MAX_VALUE_DIGITS = 11;
 
 
@@ -10,10 +10,12 @@
 #include "schemes/log_src/log_src.h"
 #include "schemes/log_src_i/log_src_i.h"
 #include "schemes/log_src_i_star/log_src_i_star.h"
+#include "schemes/multi_attr/multi_attr.h"
 #include "schemes/n_log_n/n_log_n.h"
 #include "schemes/pi_bas/pi_bas.h"
 #include "schemes/sda/sda.h"
 
+#include "utils/benchmark.h"
 #include "utils/types/basic_types.h"
 #include "utils/types/db/db.h"
 #include "utils/types/range.h"
@@ -77,6 +79,13 @@ int main() {
         config::USE_SHORTCUT_DSSE_SETUP, config::SHOULD_BENCHMARK_UPDTS
     );
 
+    std::unique_ptr<MultiAttr<LogSrcI<PiBas>>> multiAttrLogSrcIPiBas =
+        std::make_unique<MultiAttr<LogSrcI<PiBas>>>(std::make_shared<Benchmark>());
+    std::unique_ptr<MultiAttr<LogSrcI<NLogN>>> multiAttrLogSrcINLogN =
+        std::make_unique<MultiAttr<LogSrcI<NLogN>>>(std::make_shared<Benchmark>());
+    std::unique_ptr<MultiAttr<LogSrcIStar>> multiAttrLogSrcIStar =
+        std::make_unique<MultiAttr<LogSrcIStar>>(std::make_shared<Benchmark>());
+
     //--------------------------------------------------------------------------
     // debugging experiment
 
@@ -85,45 +94,68 @@ int main() {
 
     std::cout << "================ PiBas =================" << std::endl << std::endl;
     debugging.run(piBas.get(), config::SHOULD_BENCHMARK);
+    debugging.runSaveOpen(piBas.get());
 
     std::cout << "================ NLogN =================" << std::endl << std::endl;
     debugging.run(nLogN.get(), config::SHOULD_BENCHMARK);
+    debugging.runSaveOpen(nLogN.get());
 
     std::cout << "============ Log-SRC[PiBas] ============" << std::endl << std::endl;
     debugging.run(logSrcPiBas.get(), config::SHOULD_BENCHMARK);
+    debugging.runSaveOpen(logSrcPiBas.get());
 
     std::cout << "============ Log-SRC[NLogN] ============" << std::endl << std::endl;
     debugging.run(logSrcNLogN.get(), config::SHOULD_BENCHMARK);
+    debugging.runSaveOpen(logSrcNLogN.get());
 
     std::cout << "=========== Log-SRC-i[PiBas] ===========" << std::endl << std::endl;
     debugging.run(logSrcIPiBas.get(), config::SHOULD_BENCHMARK);
+    debugging.runSaveOpen(logSrcIPiBas.get());
 
     std::cout << "=========== Log-SRC-i[NLogN] ===========" << std::endl << std::endl;
     debugging.run(logSrcINLogN.get(), config::SHOULD_BENCHMARK);
+    debugging.runSaveOpen(logSrcINLogN.get());
 
     std::cout << "============== Log-SRC-i* ==============" << std::endl << std::endl;
     debugging.run(logSrcIStar.get(), config::SHOULD_BENCHMARK);
+    debugging.runSaveOpen(logSrcIStar.get());
 
     std::cout << "============== SDa[PiBas] ==============" << std::endl << std::endl;
     debugging.run(sdaPiBas.get(), config::SHOULD_BENCHMARK);
+    debugging.runSaveOpen(sdaPiBas.get());
 
     std::cout << "============== SDa[NLogN] ==============" << std::endl << std::endl;
     debugging.run(sdaNLogN.get(), config::SHOULD_BENCHMARK);
+    debugging.runSaveOpen(sdaNLogN.get());
 
     std::cout << "========= SDa[Log-SRC[PiBas]] ==========" << std::endl << std::endl;
     debugging.run(sdaLogSrcPiBas.get(), config::SHOULD_BENCHMARK);
+    debugging.runSaveOpen(sdaLogSrcPiBas.get());
 
     std::cout << "========= SDa[Log-SRC[NLogN]] ==========" << std::endl << std::endl;
     debugging.run(sdaLogSrcNLogN.get(), config::SHOULD_BENCHMARK);
+    debugging.runSaveOpen(sdaLogSrcNLogN.get());
 
     std::cout << "======== SDa[Log-SRC-i[PiBas]] =========" << std::endl << std::endl;
     debugging.run(sdaLogSrcIPiBas.get(), config::SHOULD_BENCHMARK);
+    debugging.runSaveOpen(sdaLogSrcIPiBas.get());
 
     std::cout << "======== SDa[Log-SRC-i[NLogN]] =========" << std::endl << std::endl;
     debugging.run(sdaLogSrcINLogN.get(), config::SHOULD_BENCHMARK);
+    debugging.runSaveOpen(sdaLogSrcINLogN.get());
 
     std::cout << "=========== SDa[Log-SRC-i*] ============" << std::endl << std::endl;
     debugging.run(sdaLogSrcIStar.get(), config::SHOULD_BENCHMARK);
+    debugging.runSaveOpen(sdaLogSrcIStar.get());
+
+    std::cout << "===== MultiAttr[Log-SRC-i[PiBas]] ======" << std::endl << std::endl;
+    debugging.runMultiAttr(multiAttrLogSrcIPiBas.get());
+
+    std::cout << "===== MultiAttr[Log-SRC-i[NLogN]] ======" << std::endl << std::endl;
+    debugging.runMultiAttr(multiAttrLogSrcINLogN.get());
+
+    std::cout << "======== MultiAttr[Log-SRC-i*] =========" << std::endl << std::endl;
+    debugging.runMultiAttr(multiAttrLogSrcIStar.get());
 
     // free memory ASAP
     debugging.clearDb();
@@ -2,6 +2,9 @@
 
 #include <concepts>
 #include <memory>
+#include <span>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "utils/types/basic_types.h"
@@ -28,6 +31,15 @@ public:
     ISse(std::shared_ptr<Benchmark> benchmark) : benchmark(benchmark) {}
 
     virtual void setup(int secParam, const Db<DbTuple>& db) = 0;
+
+    /**
+     * same as `setup()` above, but `db` is moved in, so schemes that need to modify their input
+     * (e.g. to add replications or sort it) can do so in place instead of copying it first.
+     * by default this just calls the copying version.
+     */
+    virtual void setup(int secParam, Db<DbTuple>&& db) {
+        this->setup(secParam, std::as_const(db));
+    }
     
     /**
      * params:
@@ -40,6 +52,27 @@ public:
         const Range<DbKw>& query, bool shouldCleanUpResults = true, bool isNaive = true
     ) const = 0;
 
+    /**
+     * search for every range in `queries` (with the same params as `search()`), e.g. for many
+     * queries issued together by one request.
+     *
+     * this default version just calls `search()` on each query in turn; schemes should override
+     * it to share work between the queries (e.g. only searching for each SRC node or point once,
+     * and looking everything up on the server together).
+     *
+     * returns: the results of each query, in the same order as `queries`.
+     */
+    virtual std::vector<std::vector<DbTuple>> searchBatch(
+        std::span<const Range<DbKw>> queries, bool shouldCleanUpResults = true, bool isNaive = true
+    ) const {
+        std::vector<std::vector<DbTuple>> allResults;
+        allResults.reserve(queries.size());
+        for (const Range<DbKw>& query : queries) {
+            allResults.push_back(this->search(query, shouldCleanUpResults, isNaive));
+        }
+        return allResults;
+    }
+
     /**
      * free memory and clear the db/index, without fully destroying this object as the
      * destructor does (so we can still call `setup()` again with the same object,
@@ -50,6 +83,19 @@ public:
      */
     virtual void clear() = 0;
 
+    /**
+     * save this scheme (its client state, and its encrypted indexes, which are moved rather than
+     * copied) into the directory `dir`, so that it can later be reopened with `open()` instead of
+     * redoing `setup()`. the saved index files are no longer deleted by `clear()`.
+     */
+    virtual void save(const std::string& dir) = 0;
+
+    /**
+     * replace this scheme with the one saved in `dir` by `save()` (by the same kind of scheme),
+     * which can then be searched as usual.
+     */
+    virtual void open(const std::string& dir) = 0;
+
 protected:
     int secParam;
 };
@@ -2,6 +2,7 @@
 
 #include <concepts>
 #include <memory>
+#include <string>
 
 #include "utils/types/basic_types.h"
 #include "utils/types/tuple.h"
@@ -19,4 +20,11 @@ public:
     ISseServer(std::shared_ptr<Benchmark> benchmark) : benchmark(benchmark) {}
 
     virtual void clear() = 0;
+
+    /**
+     * save/reopen this server's encrypted indexes in/from the directory `dir`
+     * (see `ISse::save()` and `ISse::open()`).
+     */
+    virtual void save(const std::string& dir) = 0;
+    virtual void open(const std::string& dir) = 0;
 };
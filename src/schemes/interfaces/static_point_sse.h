@@ -1,6 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <concepts>
+#include <functional>
+#include <span>
 #include <vector>
 
 #include "schemes/interfaces/sse.h"
@@ -16,7 +19,8 @@
 
 
 // subclasses of this include `PiBas`, `NLogN`, and `log_src_i_star::Underly`
-// provide shared code for `search()` (depending on `searchBase()`)
+// provide shared code for `search()` and `searchBatch()` (depending on `searchBase()` and
+// `searchBaseBatch()`)
 template <IsDbTuple DbTuple = Tuple<>>
 class IStaticPointSse : public virtual ISse<DbTuple> {
 protected:
@@ -51,6 +55,60 @@ public:
         return allResults;
     }
 
+    std::vector<std::vector<DbTuple>> searchBatch(
+        std::span<const Range<DbKw>> queries, bool shouldCleanUpResults = true, bool isNaive = true
+    ) const override {
+        // collect the distinct points (or whole ranges, if not naive) that make up the queries,
+        // so that ones shared between queries are only searched for once
+        std::vector<Range<DbKw>> baseQueries;
+        for (const Range<DbKw>& query : queries) {
+            if (isNaive) {
+                for (DbKw dbKw = query.first; dbKw <= query.second; dbKw++) {
+                    baseQueries.push_back(Range {dbKw, dbKw});
+                }
+            } else {
+                baseQueries.push_back(query);
+            }
+        }
+        std::sort(baseQueries.begin(), baseQueries.end());
+        baseQueries.erase(std::unique(baseQueries.begin(), baseQueries.end()), baseQueries.end());
+
+        std::vector<std::vector<DbTuple>> baseResults = this->searchBaseBatch(baseQueries);
+        auto appendBaseResults = [&](const Range<DbKw>& baseQuery, std::vector<DbTuple>& ret) {
+            bigint i = std::lower_bound(baseQueries.begin(), baseQueries.end(), baseQuery)
+                     - baseQueries.begin();
+            ret.insert(ret.end(), baseResults[i].begin(), baseResults[i].end());
+        };
+
+        std::vector<std::vector<DbTuple>> allResults(queries.size());
+        for (bigint i = 0; i < (bigint)queries.size(); i++) {
+            const Range<DbKw>& query = queries[i];
+            if (isNaive) {
+                for (DbKw dbKw = query.first; dbKw <= query.second; dbKw++) {
+                    appendBaseResults(Range {dbKw, dbKw}, allResults[i]);
+                }
+            } else {
+                appendBaseResults(query, allResults[i]);
+            }
+
+            if (shouldCleanUpResults) {
+                allResults[i] = utils::misc::cleanUpResults(allResults[i]);
+            }
+        }
+        return allResults;
+    }
+
+    /**
+     * streaming version of `search()` with `isNaive = false` (and no cleanup), which calls
+     * `onResult` on each result as soon as it is decrypted instead of collecting them all first,
+     * e.g. so that Log-SRC-i can fold its first round's results as they come in.
+     */
+    void searchEach(
+        const Range<DbKw>& query, const std::function<void(const DbTuple&)>& onResult
+    ) const {
+        this->searchBaseEach(query, onResult);
+    }
+
     // handle clearing of this class' member variables
     void clear() override {
         this->prfKey = utils::ustr::toUstr("");
@@ -65,17 +123,53 @@ protected:
     // methods to implement
 
     virtual std::vector<DbTuple> searchBase(const Range<DbKw>& query) const = 0;
+
+    /**
+     * batched version of `searchBase()` for several (distinct) queries at once.
+     * this default version just calls `searchBase()` on each query in turn.
+     *
+     * returns: the results of each query, in the same order as `queries`.
+     */
+    virtual std::vector<std::vector<DbTuple>> searchBaseBatch(
+        const std::vector<Range<DbKw>>& queries
+    ) const {
+        std::vector<std::vector<DbTuple>> results;
+        results.reserve(queries.size());
+        for (const Range<DbKw>& query : queries) {
+            results.push_back(this->searchBase(query));
+        }
+        return results;
+    }
+
+    /**
+     * streaming version of `searchBase()`. this default version just calls `searchBase()` and
+     * hands out its results one by one; children whose results come back from the server in
+     * several rounds should override this to decrypt each round as it arrives.
+     */
+    virtual void searchBaseEach(
+        const Range<DbKw>& query, const std::function<void(const DbTuple&)>& onResult
+    ) const {
+        for (const DbTuple& result : this->searchBase(query)) {
+            onResult(result);
+        }
+    }
     
     //--------------------------------------------------------------------------
     // shared code
 
     /**
-     * helper function to decrypt `encIndVal`.
+     * helper function to decrypt `encIndVal` (or a view of one).
      */
-    DbTuple decryptEncIndVal(const EncIndVal& encIndVal) const {
-        ustring encDbTuple = encIndVal.first;
-        ustring iv = encIndVal.second;
-        ustring decDbTuple = utils::crypto::decryptAndUnpad(this->encKey, encDbTuple, iv);
+    template <class Layout>
+    DbTuple decryptEncIndVal(const EncIndVal<Layout>& encIndVal) const {
+        return this->decryptEncIndVal(EncIndValView(encIndVal));
+    }
+
+    DbTuple decryptEncIndVal(const EncIndValView& encIndValView) const {
+        ustring decDbTuple = utils::crypto::decryptAndUnpad(
+            this->encKey, encIndValView.encData.data(), encIndValView.encData.size(),
+            encIndValView.iv.data()
+        );
         return DbTuple::fromUstr(decDbTuple);
     }
 };
@@ -1,6 +1,9 @@
 #include "schemes/log_src/log_src.h"
 
 #include <concepts>
+#include <span>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "schemes/interfaces/sse.h"
@@ -10,6 +13,8 @@
 #include "schemes/n_log_n/n_log_n.h"
 #include "schemes/pi_bas/pi_bas.h"
 
+#include "utils/misc.h"
+#include "utils/persistence.h"
 #include "utils/types/basic_types.h"
 #include "utils/types/db/db.h"
 #include "utils/types/range.h"
@@ -33,6 +38,13 @@ LogSrc<Underly>::~LogSrc() {
 
 template <template <class ...> class Underly> requires IsSse<Underly<Tuple<>>>
 void LogSrc<Underly>::setup(int secParam, const Db<Tuple<>>& db) {
+    // (we replicate into the DB, so work on a copy of it)
+    this->setup(secParam, Db<Tuple<>>(db));
+}
+
+
+template <template <class ...> class Underly> requires IsSse<Underly<Tuple<>>>
+void LogSrc<Underly>::setup(int secParam, Db<Tuple<>>&& db) {
     this->clear();
 
     //--------------------------------------------------------------------------
@@ -44,11 +56,10 @@ void LogSrc<Underly>::setup(int secParam, const Db<Tuple<>>& db) {
     //--------------------------------------------------------------------------
     // build index
 
-    // build TDAG over `Kw`s and replicate `db` appropriately
-    Db<Tuple<>> dbWithRepls = db;
-    log_src::utils::buildTdagDbFromLeaves<Tuple<>>(dbWithRepls, this->tdag);
+    // build TDAG over `Kw`s and replicate `db` appropriately (in place)
+    log_src::utils::buildTdagDbFromLeaves<Tuple<>>(db, this->tdag);
 
-    this->underly->setup(secParam, dbWithRepls);
+    this->underly->setup(secParam, std::move(db));
 }
 
 
@@ -60,13 +71,58 @@ std::vector<Tuple<>> LogSrc<Underly>::search(
     if (Range<Kw>::isDummy(src)) {
         return std::vector<Tuple<>> {};
     }
-    return this->underly->search(src, shouldCleanUpResults, false);
+
+    std::vector<Tuple<>> results;
+    if (!this->srcResultsCache.get(src, results)) {
+        results = this->underly->search(src, false, false);
+        this->srcResultsCache.put(src, results);
+    }
+    if (shouldCleanUpResults) {
+        results = utils::misc::cleanUpResults(results);
+    }
+    return results;
+}
+
+
+template <template <class ...> class Underly> requires IsSse<Underly<Tuple<>>>
+std::vector<std::vector<Tuple<>>> LogSrc<Underly>::searchBatch(
+    std::span<const Range<Kw>> queries, bool shouldCleanUpResults, [[maybe_unused]] bool isNaive
+) const {
+    // search for the SRC nodes of all queries that aren't cached together (so nodes shared
+    // between queries are only searched for once by the underlying scheme)
+    std::vector<std::vector<Tuple<>>> allResults(queries.size());
+    std::vector<Range<Kw>> srcs;
+    std::vector<bigint> srcQueryInds;
+    for (bigint i = 0; i < (bigint)queries.size(); i++) {
+        Range<Kw> src = this->tdag->findSrc(queries[i]);
+        if (Range<Kw>::isDummy(src) || this->srcResultsCache.get(src, allResults[i])) {
+            continue;
+        }
+        srcs.push_back(src);
+        srcQueryInds.push_back(i);
+    }
+    if (!srcs.empty()) {
+        std::vector<std::vector<Tuple<>>> srcResults =
+            this->underly->searchBatch(srcs, false, false);
+        for (bigint i = 0; i < (bigint)srcs.size(); i++) {
+            this->srcResultsCache.put(srcs[i], srcResults[i]);
+            allResults[srcQueryInds[i]] = std::move(srcResults[i]);
+        }
+    }
+
+    if (shouldCleanUpResults) {
+        for (std::vector<Tuple<>>& results : allResults) {
+            results = utils::misc::cleanUpResults(results);
+        }
+    }
+    return allResults;
 }
 
 
 template <template <class ...> class Underly> requires IsSse<Underly<Tuple<>>>
 void LogSrc<Underly>::clear() {
     this->underly->clear();
+    this->srcResultsCache.clear();
 
     // delete TDAG fully since it is reallocated with `new` in `setup()`
     if (this->tdag != nullptr) {
@@ -79,6 +135,30 @@ void LogSrc<Underly>::clear() {
 }
 
 
+template <template <class ...> class Underly> requires IsSse<Underly<Tuple<>>>
+void LogSrc<Underly>::save(const std::string& dir) {
+    utils::persistence::StateWriter state(dir, "log_src");
+    state.write(this->secParam);
+    state.write(this->size);
+    log_src::utils::saveTdag(state, this->tdag);
+    // (the state file only gets moved into place once the underlying scheme is saved)
+    this->underly->save(utils::persistence::joinPath(dir, "underly"));
+    state.close();
+}
+
+
+template <template <class ...> class Underly> requires IsSse<Underly<Tuple<>>>
+void LogSrc<Underly>::open(const std::string& dir) {
+    this->clear();
+
+    utils::persistence::StateReader state(dir, "log_src");
+    this->secParam = state.readBigint();
+    this->size = state.readBigint();
+    log_src::utils::openTdag(state, this->tdag);
+    this->underly->open(utils::persistence::joinPath(dir, "underly"));
+}
+
+
 //------------------------------------------------------------------------------
 // `ISdUnderly`
 
@@ -1,13 +1,18 @@
 #pragma once
 
 #include <concepts>
+#include <span>
+#include <string>
 #include <vector>
 
+#include "config.h"
+
 #include "schemes/interfaces/sd_underly.h"
 #include "schemes/interfaces/sse.h"
 
 #include "utils/types/basic_types.h"
 #include "utils/types/db/db.h"
+#include "utils/types/lru_cache.h"
 #include "utils/types/range.h"
 #include "utils/types/tdag.h"
 #include "utils/types/tuple.h"
@@ -27,10 +32,16 @@ public:
     // `ISse`
 
     void setup(int secParam, const Db<Tuple<>>& db) override;
+    void setup(int secParam, Db<Tuple<>>&& db) override;
     std::vector<Tuple<>> search(
         const Range<Kw>& query, bool shouldCleanUpResults = true, bool isNaive = true
     ) const override;
+    std::vector<std::vector<Tuple<>>> searchBatch(
+        std::span<const Range<Kw>> queries, bool shouldCleanUpResults = true, bool isNaive = true
+    ) const override;
     void clear() override;
+    void save(const std::string& dir) override;
+    void open(const std::string& dir) override;
 
     //--------------------------------------------------------------------------
     // `ISdUnderly`
@@ -40,4 +51,6 @@ public:
 private:
     Underly<Tuple<>>* underly = new Underly<Tuple<>>(this->benchmark);
     TdagNode<Kw>* tdag = nullptr;
+    // (uncleaned) results of recently searched SRC nodes
+    mutable LruCache<Range<Kw>, Tuple<>> srcResultsCache {config::SRC_RESULTS_CACHE_CAPACITY};
 };
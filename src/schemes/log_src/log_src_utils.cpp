@@ -3,6 +3,7 @@
 #include <concepts>
 #include <list>
 
+#include "utils/persistence.h"
 #include "utils/types/basic_types.h"
 #include "utils/types/db/db.h"
 #include "utils/types/range.h"
@@ -56,6 +57,30 @@ void replTdagDb(Db<DbTuple>& db, const TdagNode<typename DbTuple::DbKwType>* tda
 }
 
 
+template <std::integral T>
+void saveTdag(::utils::persistence::StateWriter& state, const TdagNode<T>* tdag) {
+    state.write(tdag != nullptr);
+    if (tdag != nullptr) {
+        Range<T> leafRange = tdag->getRange();
+        state.write(leafRange.first);
+        state.write(leafRange.second);
+    }
+}
+
+
+template <std::integral T>
+void openTdag(::utils::persistence::StateReader& state, TdagNode<T>*& tdag) {
+    bool hasTdag = state.readBigint();
+    if (hasTdag) {
+        T leafRangeStart = state.readBigint();
+        T leafRangeEnd = state.readBigint();
+        tdag = new TdagNode<T>(leafRangeStart, leafRangeEnd);
+    } else {
+        tdag = nullptr;
+    }
+}
+
+
 //------------------------------------------------------------------------------
 // explicit template instantiations
 
@@ -76,4 +101,9 @@ template void replTdagDb<SrcIDb1Tuple>(Db<SrcIDb1Tuple>& db, const TdagNode<Kw>*
 //template void replTdagDb<Tuple<IdAlias>>(Db<Tuple<IdAlias>>& db, const TdagNode<IdAlias>* tdag);
 
 
+// (`Kw` and `IdAlias` are the same type, so this covers both)
+template void saveTdag<Kw>(::utils::persistence::StateWriter& state, const TdagNode<Kw>* tdag);
+template void openTdag<Kw>(::utils::persistence::StateReader& state, TdagNode<Kw>*& tdag);
+
+
 } // namespace `log_src::utils`
@@ -2,6 +2,7 @@
 
 #include <concepts>
 
+#include "utils/persistence.h"
 #include "utils/types/db/db.h"
 #include "utils/types/tdag.h"
 #include "utils/types/tuple.h"
@@ -20,4 +21,15 @@ template <IsDbTuple DbTuple>
 void replTdagDb(Db<DbTuple>& db, const TdagNode<typename DbTuple::DbKwType>* tdag);
 
 
+/**
+ * write/read back `tdag` as part of a scheme's client state (see `ISse::save()`). since a TDAG
+ * is fully determined by its leaf range, only that is saved, and the TDAG is rebuilt on open.
+ */
+template <std::integral T>
+void saveTdag(::utils::persistence::StateWriter& state, const TdagNode<T>* tdag);
+
+template <std::integral T>
+void openTdag(::utils::persistence::StateReader& state, TdagNode<T>*& tdag);
+
+
 } // namespace `log_src::utils`
@@ -4,15 +4,21 @@
 #include <concepts>
 #include <cstdlib>
 #include <iostream>
+#include <span>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "schemes/interfaces/sse.h"
+#include "schemes/log_src/log_src_utils.h"
 
 // for explicit template instantiation
 #include "schemes/log_src_i_star/log_src_i_star_underly.h"
 #include "schemes/n_log_n/n_log_n.h"
 #include "schemes/pi_bas/pi_bas.h"
 
+#include "utils/misc.h"
+#include "utils/persistence.h"
 #include "utils/types/basic_types.h"
 #include "utils/types/db/db.h"
 #include "utils/types/ind.h"
@@ -49,47 +55,103 @@ template <template <class ...> class Underly> requires IsSse<Underly<Tuple<>>>
 std::vector<Tuple<>> LogSrcIBase<Underly>::search(
     const Range<Kw>& query, bool shouldCleanUpResults, bool isNaive
 ) const {
+    Range<IdAlias> query2 = this->searchIdAliasRange(query);
+    // if there are no choices or something went wrong
+    if (Range<IdAlias>::isDummy(query2)) {
+        return std::vector<Tuple<>> {};
+    }
+    return this->searchIdAliases(query2, shouldCleanUpResults);
+}
+
+
+template <template <class ...> class Underly> requires IsSse<Underly<Tuple<>>>
+std::vector<std::vector<Tuple<>>> LogSrcIBase<Underly>::searchBatch(
+    std::span<const Range<Kw>> queries, bool shouldCleanUpResults, [[maybe_unused]] bool isNaive
+) const {
+    std::vector<std::vector<Tuple<>>> allResults(queries.size());
+
     //--------------------------------------------------------------------------
     // query 1
 
-    Range<Kw> src1 = this->tdag1->findSrc(query);
-    if (Range<Kw>::isDummy(src1)) {
-        return std::vector<Tuple<>> {};
+    // search for the SRC nodes of all queries that aren't cached together (so nodes shared
+    // between queries are only searched for once by the underlying scheme)
+    std::vector<Range<Kw>> src1s;
+    std::vector<bigint> src1QueryInds;
+    std::vector<std::vector<SrcIDb1Tuple>> query1Results;
+    std::vector<Range<Kw>> uncachedSrc1s;
+    std::vector<bigint> uncachedSrc1Inds;
+    for (bigint i = 0; i < (bigint)queries.size(); i++) {
+        Range<Kw> src1 = this->tdag1->findSrc(queries[i]);
+        if (Range<Kw>::isDummy(src1)) {
+            continue;
+        }
+        src1s.push_back(src1);
+        src1QueryInds.push_back(i);
+        if (!this->src1ResultsCache.get(src1, query1Results.emplace_back())) {
+            uncachedSrc1s.push_back(src1);
+            uncachedSrc1Inds.push_back(src1s.size() - 1);
+        }
+    }
+    if (!uncachedSrc1s.empty()) {
+        std::vector<std::vector<SrcIDb1Tuple>> uncachedQuery1Results =
+            this->underly1->searchBatch(uncachedSrc1s, false, false);
+        for (bigint i = 0; i < (bigint)uncachedSrc1s.size(); i++) {
+            this->src1ResultsCache.put(uncachedSrc1s[i], uncachedQuery1Results[i]);
+            query1Results[uncachedSrc1Inds[i]] = std::move(uncachedQuery1Results[i]);
+        }
     }
-    std::vector<SrcIDb1Tuple> query1Results = this->underly1->search(src1, false, false);
 
     //--------------------------------------------------------------------------
     // query 2
 
-    // generate query for query 2 based on query 1 results
-    // (filter out unnecessary choices and merge remaining ones into a single id range)
-    IdAlias minIdAlias = DUMMY;
-    IdAlias maxIdAlias = DUMMY;
-    for (const SrcIDb1Tuple& query1Result : query1Results) {
-        Kw kw = query1Result.getKw();
-        if (!query.contains(kw)) {
-            continue;
+    // generate query for query 2 of each query based on its query 1 results, same as `search()`
+    std::vector<Range<IdAlias>> src2s;
+    std::vector<bigint> src2QueryInds;
+    for (bigint i = 0; i < (bigint)src1s.size(); i++) {
+        const Range<Kw>& query = queries[src1QueryInds[i]];
+        IdAlias minIdAlias = DUMMY;
+        IdAlias maxIdAlias = DUMMY;
+        for (const SrcIDb1Tuple& query1Result : query1Results[i]) {
+            Kw kw = query1Result.getKw();
+            if (!query.contains(kw)) {
+                continue;
+            }
+            Range<IdAlias> idAliasRange = query1Result.getIdAliasRange();
+            if (idAliasRange.first < minIdAlias || minIdAlias == DUMMY) {
+                minIdAlias = idAliasRange.first;
+            }
+            if (idAliasRange.second > maxIdAlias || maxIdAlias == DUMMY) {
+                maxIdAlias = idAliasRange.second;
+            }
         }
-        Range<IdAlias> idAliasRange = query1Result.getIdAliasRange();
-        if (idAliasRange.first < minIdAlias || minIdAlias == DUMMY) {
-            minIdAlias = idAliasRange.first;
+        // if there are no choices or something went wrong
+        if (minIdAlias == DUMMY || maxIdAlias == DUMMY) {
+            continue;
         }
-        if (idAliasRange.second > maxIdAlias || maxIdAlias == DUMMY) {
-            maxIdAlias = idAliasRange.second;
+
+        Range<IdAlias> src2 = this->tdag2->findSrc(Range<IdAlias> {minIdAlias, maxIdAlias});
+        if (Range<IdAlias>::isDummy(src2)
+                || this->src2ResultsCache.get(src2, allResults[src1QueryInds[i]])) {
+            continue;
         }
+        src2s.push_back(src2);
+        src2QueryInds.push_back(src1QueryInds[i]);
     }
-    // if there are no choices or something went wrong
-    if (minIdAlias == DUMMY || maxIdAlias == DUMMY) {
-        return std::vector<Tuple<>> {};
+    if (!src2s.empty()) {
+        std::vector<std::vector<Tuple<>>> query2Results =
+            this->underly2->searchBatch(src2s, false, false);
+        for (bigint i = 0; i < (bigint)src2s.size(); i++) {
+            this->src2ResultsCache.put(src2s[i], query2Results[i]);
+            allResults[src2QueryInds[i]] = std::move(query2Results[i]);
+        }
     }
 
-    // perform query 2
-    Range<IdAlias> query2 {minIdAlias, maxIdAlias};
-    Range<IdAlias> src2 = this->tdag2->findSrc(query2);
-    if (Range<IdAlias>::isDummy(src2)) {
-        return std::vector<Tuple<>> {};
+    if (shouldCleanUpResults) {
+        for (std::vector<Tuple<>>& results : allResults) {
+            results = utils::misc::cleanUpResults(results);
+        }
     }
-    return this->underly2->search(src2, shouldCleanUpResults, false);
+    return allResults;
 }
 
 
@@ -97,6 +159,8 @@ template <template <class ...> class Underly> requires IsSse<Underly<Tuple<>>>
 void LogSrcIBase<Underly>::clear() {
     this->underly1->clear();
     this->underly2->clear();
+    this->src1ResultsCache.clear();
+    this->src2ResultsCache.clear();
 
     if (this->tdag1 != nullptr) {
         delete this->tdag1;
@@ -112,6 +176,34 @@ void LogSrcIBase<Underly>::clear() {
 }
 
 
+template <template <class ...> class Underly> requires IsSse<Underly<Tuple<>>>
+void LogSrcIBase<Underly>::save(const std::string& dir) {
+    utils::persistence::StateWriter state(dir, "log_src_i");
+    state.write(this->secParam);
+    state.write(this->size);
+    log_src::utils::saveTdag(state, this->tdag1);
+    log_src::utils::saveTdag(state, this->tdag2);
+    // (the state file only gets moved into place once the underlying schemes are saved)
+    this->underly1->save(utils::persistence::joinPath(dir, "underly_1"));
+    this->underly2->save(utils::persistence::joinPath(dir, "underly_2"));
+    state.close();
+}
+
+
+template <template <class ...> class Underly> requires IsSse<Underly<Tuple<>>>
+void LogSrcIBase<Underly>::open(const std::string& dir) {
+    this->clear();
+
+    utils::persistence::StateReader state(dir, "log_src_i");
+    this->secParam = state.readBigint();
+    this->size = state.readBigint();
+    log_src::utils::openTdag(state, this->tdag1);
+    log_src::utils::openTdag(state, this->tdag2);
+    this->underly1->open(utils::persistence::joinPath(dir, "underly_1"));
+    this->underly2->open(utils::persistence::joinPath(dir, "underly_2"));
+}
+
+
 //------------------------------------------------------------------------------
 // `ISdUnderly`
 
@@ -142,14 +234,13 @@ void LogSrcIBase<Underly>::getDb(Db<Tuple<>>& ret) const {
 
         for (IdAlias idAlias = idAliasRange.first; idAlias <= idAliasRange.second; idAlias++) {
             Range<IdAlias> idAliasRange {idAlias, idAlias};
-            auto iter = ind2.find(idAliasRange);
-            if (iter == ind2.end()) {
+            if (!ind2.contains(idAliasRange)) {
                 std::cerr << "Error: LogSrcIBase::getDb(): id alias range " << idAliasRange
                           << " not found in index 2" << std::endl;
                 std::exit(EXIT_FAILURE);
             }
 
-            Db<Tuple<IdAlias>> dbKwList = std::move(iter->second);
+            std::span<const Tuple<IdAlias>> dbKwList = ind2[idAliasRange];
             for (const Tuple<IdAlias>& db2Tuple : dbKwList) {
                 Tuple<> newTuple(db2Tuple.getDbDoc(), kwRange);
                 ret.push_back(newTuple);
@@ -159,6 +250,81 @@ void LogSrcIBase<Underly>::getDb(Db<Tuple<>>& ret) const {
 } 
 
 
+//------------------------------------------------------------------------------
+// rounds of `search()`
+
+
+template <template <class ...> class Underly> requires IsSse<Underly<Tuple<>>>
+Range<IdAlias> LogSrcIBase<Underly>::searchIdAliasRange(const Range<Kw>& query) const {
+    Range<Kw> src1 = this->tdag1->findSrc(query);
+    if (Range<Kw>::isDummy(src1)) {
+        return Range<IdAlias>::DUMMY();
+    }
+
+    // generate query for query 2 based on query 1 results
+    // (filter out unnecessary choices and merge remaining ones into a single id range);
+    // this is folded in as each result is decrypted rather than after query 1 finishes, so that
+    // query 2 can be sent out as soon as the last one comes back (and with a pipelined underlying
+    // scheme, the client's decryption overlaps with the server still reading later results)
+    IdAlias minIdAlias = DUMMY;
+    IdAlias maxIdAlias = DUMMY;
+    auto foldQuery1Result = [&](const SrcIDb1Tuple& query1Result) {
+        Kw kw = query1Result.getKw();
+        if (!query.contains(kw)) {
+            return;
+        }
+        Range<IdAlias> idAliasRange = query1Result.getIdAliasRange();
+        if (idAliasRange.first < minIdAlias || minIdAlias == DUMMY) {
+            minIdAlias = idAliasRange.first;
+        }
+        if (idAliasRange.second > maxIdAlias || maxIdAlias == DUMMY) {
+            maxIdAlias = idAliasRange.second;
+        }
+    };
+    std::vector<SrcIDb1Tuple> query1Results;
+    if (this->src1ResultsCache.get(src1, query1Results)) {
+        for (const SrcIDb1Tuple& query1Result : query1Results) {
+            foldQuery1Result(query1Result);
+        }
+    } else if (this->src1ResultsCache.isEnabled()) {
+        this->underly1->searchEach(src1, [&](const SrcIDb1Tuple& query1Result) {
+            foldQuery1Result(query1Result);
+            query1Results.push_back(query1Result);
+        });
+        this->src1ResultsCache.put(src1, query1Results);
+    } else {
+        this->underly1->searchEach(src1, foldQuery1Result);
+    }
+
+    // if there are no choices or something went wrong
+    if (minIdAlias == DUMMY || maxIdAlias == DUMMY) {
+        return Range<IdAlias>::DUMMY();
+    }
+    return Range<IdAlias> {minIdAlias, maxIdAlias};
+}
+
+
+template <template <class ...> class Underly> requires IsSse<Underly<Tuple<>>>
+std::vector<Tuple<>> LogSrcIBase<Underly>::searchIdAliases(
+    const Range<IdAlias>& idAliasRange, bool shouldCleanUpResults
+) const {
+    Range<IdAlias> src2 = this->tdag2->findSrc(idAliasRange);
+    if (Range<IdAlias>::isDummy(src2)) {
+        return std::vector<Tuple<>> {};
+    }
+
+    std::vector<Tuple<>> results;
+    if (!this->src2ResultsCache.get(src2, results)) {
+        results = this->underly2->search(src2, false, false);
+        this->src2ResultsCache.put(src2, results);
+    }
+    if (shouldCleanUpResults) {
+        results = utils::misc::cleanUpResults(results);
+    }
+    return results;
+}
+
+
 //------------------------------------------------------------------------------
 // explicit template instantiations
 
@@ -1,13 +1,18 @@
 #pragma once
 
 #include <concepts>
+#include <span>
+#include <string>
 #include <vector>
 
+#include "config.h"
+
 #include "schemes/interfaces/sd_underly.h"
 #include "schemes/interfaces/sse.h"
 
 #include "utils/types/basic_types.h"
 #include "utils/types/db/db.h"
+#include "utils/types/lru_cache.h"
 #include "utils/types/range.h"
 #include "utils/types/tdag.h"
 #include "utils/types/tuple.h"
@@ -30,16 +35,60 @@ public:
     std::vector<Tuple<>> search(
         const Range<Kw>& query, bool shouldCleanUpResults = true, bool isNaive = true
     ) const override;
+    std::vector<std::vector<Tuple<>>> searchBatch(
+        std::span<const Range<Kw>> queries, bool shouldCleanUpResults = true, bool isNaive = true
+    ) const override;
     void clear() override;
+    void save(const std::string& dir) override;
+    void open(const std::string& dir) override;
 
     //--------------------------------------------------------------------------
     // `ISdUnderly`
 
     void getDb(Db<Tuple<>>& ret) const override;
 
+    //--------------------------------------------------------------------------
+    // rounds of `search()`
+
+    // `search()` is exactly `searchIdAliasRange()` followed by `searchIdAliases()`; these are
+    // exposed separately so that callers combining several indexes (e.g. `MultiAttr`) can look at
+    // how many results each query has (the size of its id alias range) before fetching any of them
+
+    /**
+     * run query 1 only.
+     *
+     * returns: the range of id aliases holding the results of `query` (one id alias per result,
+     * including any deletion tuples), or `Range<IdAlias>::DUMMY()` if there are none.
+     */
+    Range<IdAlias> searchIdAliasRange(const Range<Kw>& query) const;
+
+    /**
+     * run query 2 only, for an id alias range returned by `searchIdAliasRange()`.
+     *
+     * note that, like `search()`, this may also return false positives (tuples with keywords
+     * outside the original query) from the SRC node covering `idAliasRange`.
+     */
+    std::vector<Tuple<>> searchIdAliases(
+        const Range<IdAlias>& idAliasRange, bool shouldCleanUpResults = true
+    ) const;
+
 protected:
     Underly<SrcIDb1Tuple>* underly1 = new Underly<SrcIDb1Tuple>(this->benchmark);
     Underly<Tuple<IdAlias>>* underly2 = new Underly<Tuple<IdAlias>>(this->benchmark);
     TdagNode<Kw>* tdag1 = nullptr;
     TdagNode<IdAlias>* tdag2 = nullptr;
+    // (uncleaned) results of recently searched SRC nodes in either index
+    mutable LruCache<Range<Kw>, SrcIDb1Tuple> src1ResultsCache {
+        config::SRC_RESULTS_CACHE_CAPACITY
+    };
+    mutable LruCache<Range<IdAlias>, Tuple<IdAlias>> src2ResultsCache {
+        config::SRC_RESULTS_CACHE_CAPACITY
+    };
+};
+
+
+// i.e. `LogSrcI<...>` or `LogSrcIStar`
+template <class T>
+concept IsLogSrcI = requires(T t) {
+    []<template <class ...> class Underly>(LogSrcIBase<Underly>&){}(t);
 };
@@ -11,14 +11,11 @@
 namespace log_src_i::utils {
 
 
-Db<Tuple<>> sortInputDbByKw(const Db<Tuple<>>& db) {
-    Db<Tuple<>> sortedDb = db;
-
+void sortInputDbByKw(Db<Tuple<>>& db) {
     auto sortByKw = [](const Tuple<>& tuple1, const Tuple<>& tuple2) {
         return tuple1.getKw() < tuple2.getKw();
     };
-    sortedDb.sort(sortByKw);
-    return sortedDb;
+    db.sort(sortByKw);
 }
 
 
@@ -10,7 +10,10 @@
 namespace log_src_i::utils {
 
 
-Db<Tuple<>> sortInputDbByKw(const Db<Tuple<>>& db);
+/**
+ * sort `db` by keyword (in place).
+ */
+void sortInputDbByKw(Db<Tuple<>>& db);
 
 
 /**
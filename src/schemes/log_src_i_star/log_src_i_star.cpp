@@ -17,6 +17,12 @@
 
 
 void LogSrcIStar::setup(int secParam, const Db<Tuple<>>& db) {
+    // (we sort the DB, so work on a copy of it)
+    this->setup(secParam, Db<Tuple<>>(db));
+}
+
+
+void LogSrcIStar::setup(int secParam, Db<Tuple<>>&& db) {
     this->clear();
 
     //--------------------------------------------------------------------------
@@ -28,8 +34,9 @@ void LogSrcIStar::setup(int secParam, const Db<Tuple<>>& db) {
     //--------------------------------------------------------------------------
     // init sub-DBs
 
-    // sort documents by keyword
-    Db<Tuple<>> sortedDb = log_src_i::utils::sortInputDbByKw(db);
+    // sort documents by keyword (in place)
+    log_src_i::utils::sortInputDbByKw(db);
+    const Db<Tuple<>>& sortedDb = db;
 
     // assign index 2 nodes/"identifier aliases" and populate both `db1` and `db2`
     // leaves with this information
@@ -24,4 +24,5 @@ public:
      *     - tuples in `db` cannot have keyword equal to `DUMMY`.
      */
     void setup(int secParam, const Db<Tuple<>>& db) override;
+    void setup(int secParam, Db<Tuple<>>&& db) override;
 };
@@ -1,13 +1,14 @@
 #include "schemes/log_src_i_star/log_src_i_star_underly.h"
 
-#include <cmath>
 #include <concepts>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "utils/int_math.h"
+#include "utils/persistence.h"
 #include "utils/types/basic_types.h"
 #include "utils/types/db/db.h"
-#include "utils/types/enc_ind/enc_ind_utils.h"
 #include "utils/types/range.h"
 #include "utils/types/tuple.h"
 #include "utils/types/ustring.h"
@@ -34,38 +35,23 @@ void Underly<DbTuple>::setup(int secParam, const Db<DbTuple>& db) {
 
 
 template <IsDbTuple DbTuple>
-std::vector<DbTuple> Underly<DbTuple>::searchBase(const Range<DbKw>& query) const {
-    std::vector<DbTuple> results;
-
-    // PRF(K_1, w)
-    ustring queryToken = this->genQueryToken(query);
-
+std::vector<std::vector<DbTuple>> Underly<DbTuple>::searchBaseBatch(
+    const std::vector<Range<DbKw>>& queries
+) const {
+    // PRF(K_1, w) for every query
+    std::vector<ustring> queryTokens;
+    queryTokens.reserve(queries.size());
     // for Log-SRC-i*, the number of results from either index and hence the level
     // to search is exactly the size of the queried range/SRC node, so we don't have to
     // additionally store an encrypted map (and result size is leaked to server anyway)
-    bigint dbKwCount = query.size();
-    bigint dbKwPaddedCount = std::pow(2, std::ceil(std::log2(dbKwCount))); // this is bucket size
-
-    // compute `lvl` and `pos` of correct bucket (the same way as in `setup()`)
-    ustring label;
-    std::pair<ubigint, ubigint> lvlAndPos = this->map(queryToken, dbKwPaddedCount, label);
-    ubigint lvl = lvlAndPos.first;
-    ubigint pos = lvlAndPos.second;
-    // return entire bucket (`dbKwPaddedCount` instead of `dbKwCount`) from server
-    // to hide true result size
-    ubigint startPos = pos * this->calcBcktSizeOnLvl(lvl);
-    std::vector<EncIndVal> encResults = this->server->searchEncIndForBckt(
-        lvl, startPos, dbKwPaddedCount, label
-    );
-
-    // decrypt results on the client
-    results.reserve(encResults.size());
-    for (const EncIndVal& encResult : encResults) {
-        DbTuple result = this->decryptEncIndVal(encResult);
-        results.push_back(result);
+    std::vector<bigint> dbKwCounts;
+    dbKwCounts.reserve(queries.size());
+    for (const Range<DbKw>& query : queries) {
+        queryTokens.push_back(this->genQueryToken(query));
+        dbKwCounts.push_back(query.size());
     }
 
-    return results;
+    return this->searchBckts(queryTokens, dbKwCounts);
 }
 
 
@@ -73,12 +59,28 @@ std::vector<DbTuple> Underly<DbTuple>::searchBase(const Range<DbKw>& query) cons
 // helpers
 
 
+template <IsDbTuple DbTuple>
+void Underly<DbTuple>::saveState(utils::persistence::StateWriter& state) const {
+    NLogN<DbTuple>::saveState(state);
+
+    state.write(this->leafCount);
+}
+
+
+template <IsDbTuple DbTuple>
+void Underly<DbTuple>::openState(utils::persistence::StateReader& state) {
+    NLogN<DbTuple>::openState(state);
+
+    this->leafCount = state.readBigint();
+}
+
+
 template <IsDbTuple DbTuple>
 bigint Underly<DbTuple>::calcLvlCount() const {
     // the key to avoiding the blowup of using NLogN as a black box is by using
     // `leafCount` instead of `this->size` here, since `this->size` includes the
     // replicated tuples and using it sort of assumes those are only the "raw" tuples
-    return std::ceil(std::log2(this->leafCount)) + 1;
+    return utils::int_math::ceilLog2(this->leafCount) + 1;
 }
 
 
@@ -88,7 +90,7 @@ bigint Underly<DbTuple>::calcBcktCountOnLvl(bigint lvl) const {
         return this->leafCount;
     } else {
         // this gives the TDAG-specific node/bucket count at level `lvl` (for `lvl` >= 1)
-        return std::pow(2, this->lvlCount - lvl) - 1;
+        return utils::int_math::pow2(this->lvlCount - lvl) - 1;
     }
 }
 
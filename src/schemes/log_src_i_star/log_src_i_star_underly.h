@@ -1,10 +1,12 @@
 #pragma once
 
 #include <concepts>
+#include <string>
 #include <vector>
 
 #include "schemes/n_log_n/n_log_n.h" 
 
+#include "utils/persistence.h"
 #include "utils/types/basic_types.h"
 #include "utils/types/db/db.h"
 #include "utils/types/range.h"
@@ -36,11 +38,17 @@ private:
     //--------------------------------------------------------------------------
     // `IStaticPointSse`
 
-    std::vector<DbTuple> searchBase(const Range<DbKw>& query) const override;
+    std::vector<std::vector<DbTuple>> searchBaseBatch(
+        const std::vector<Range<DbKw>>& queries
+    ) const override;
 
     //--------------------------------------------------------------------------
     // helpers
 
+    constexpr std::string STATE_NAME() const override { return "log_src_i_star_underly"; }
+    void saveState(utils::persistence::StateWriter& state) const override;
+    void openState(utils::persistence::StateReader& state) override;
+
     bigint calcLvlCount() const override;
     bigint calcBcktCountOnLvl(bigint lvl) const override;
 };
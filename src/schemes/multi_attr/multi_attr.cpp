@@ -0,0 +1,201 @@
+#include "schemes/multi_attr/multi_attr.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "schemes/log_src_i/log_src_i_base.h"
+
+// for explicit template instantiation
+#include "schemes/log_src_i/log_src_i.h"
+#include "schemes/log_src_i_star/log_src_i_star.h"
+#include "schemes/n_log_n/n_log_n.h"
+#include "schemes/pi_bas/pi_bas.h"
+
+#include "utils/persistence.h"
+#include "utils/types/basic_types.h"
+#include "utils/types/db/db.h"
+#include "utils/types/range.h"
+#include "utils/types/tuple.h"
+
+
+template <IsLogSrcI AttrSse>
+MultiAttr<AttrSse>::~MultiAttr() {
+    this->clear();
+}
+
+
+template <IsLogSrcI AttrSse>
+void MultiAttr<AttrSse>::setup(int secParam, const std::vector<Db<Tuple<>>>& attrDbs) {
+    this->clear();
+    this->secParam = secParam;
+
+    for (const Db<Tuple<>>& attrDb : attrDbs) {
+        AttrSse* attrSse = new AttrSse(this->benchmark);
+        attrSse->setup(secParam, attrDb);
+        this->attrSses.push_back(attrSse);
+    }
+}
+
+
+template <IsLogSrcI AttrSse>
+std::vector<Id> MultiAttr<AttrSse>::search(
+    const std::vector<Range<Kw>>& query, bool isConjunctive
+) const {
+    if (query.size() != this->attrSses.size()) {
+        std::cerr << "Error: MultiAttr::search(): query has " << query.size()
+                  << " ranges but there are " << this->attrSses.size() << " attributes"
+                  << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    //--------------------------------------------------------------------------
+    // query 1 of every filtered attribute
+
+    // (attribute, id alias range) pairs of the attributes that have any results;
+    // the size of each id alias range is the number of results of that attribute (counting
+    // deletion tuples)
+    std::vector<std::pair<bigint, Range<IdAlias>>> attrIdAliasRanges;
+    for (bigint attr = 0; attr < (bigint)query.size(); attr++) {
+        if (Range<Kw>::isDummy(query[attr])) {
+            continue;
+        }
+        Range<IdAlias> idAliasRange = this->attrSses[attr]->searchIdAliasRange(query[attr]);
+        if (Range<IdAlias>::isDummy(idAliasRange)) {
+            // if one attribute has no results, neither does the whole conjunction
+            // (so we don't even need to finish query 1 of the others)
+            if (isConjunctive) {
+                return std::vector<Id> {};
+            }
+            continue;
+        }
+        attrIdAliasRanges.emplace_back(attr, idAliasRange);
+    }
+    if (attrIdAliasRanges.empty()) {
+        return std::vector<Id> {};
+    }
+
+    //--------------------------------------------------------------------------
+    // query 2 of each attribute, combining results as we go
+
+    if (!isConjunctive) {
+        std::vector<Id> ids;
+        for (const auto& [attr, idAliasRange] : attrIdAliasRanges) {
+            std::vector<Id> attrIds = this->searchAttrIds(attr, query[attr], idAliasRange);
+            std::vector<Id> newIds;
+            newIds.reserve(ids.size() + attrIds.size());
+            std::set_union(
+                ids.begin(), ids.end(), attrIds.begin(), attrIds.end(),
+                std::back_inserter(newIds)
+            );
+            ids = std::move(newIds);
+        }
+        return ids;
+    }
+
+    // smallest first, so that we fetch as few results as possible before the intersection
+    // possibly becomes empty, and each intersection is against the smallest possible set
+    std::sort(
+        attrIdAliasRanges.begin(), attrIdAliasRanges.end(),
+        [](const std::pair<bigint, Range<IdAlias>>& a, const std::pair<bigint, Range<IdAlias>>& b) {
+            return a.second.size() < b.second.size();
+        }
+    );
+    auto [firstAttr, firstIdAliasRange] = attrIdAliasRanges[0];
+    std::vector<Id> ids = this->searchAttrIds(firstAttr, query[firstAttr], firstIdAliasRange);
+    for (bigint i = 1; i < (bigint)attrIdAliasRanges.size() && !ids.empty(); i++) {
+        const auto& [attr, idAliasRange] = attrIdAliasRanges[i];
+        std::vector<Id> attrIds = this->searchAttrIds(attr, query[attr], idAliasRange);
+        // (sorted merge, so the result is sorted again for the next attribute)
+        std::vector<Id> newIds;
+        std::set_intersection(
+            ids.begin(), ids.end(), attrIds.begin(), attrIds.end(), std::back_inserter(newIds)
+        );
+        ids = std::move(newIds);
+    }
+    return ids;
+}
+
+
+template <IsLogSrcI AttrSse>
+void MultiAttr<AttrSse>::clear() {
+    // (apparently vector `clear()` automatically calls the destructor for each element
+    // *unless* it is a pointer)
+    for (AttrSse* attrSse : this->attrSses) {
+        if (attrSse != nullptr) {
+            delete attrSse;
+            attrSse = nullptr;
+        }
+    }
+    this->attrSses.clear();
+}
+
+
+template <IsLogSrcI AttrSse>
+void MultiAttr<AttrSse>::save(const std::string& dir) {
+    utils::persistence::StateWriter state(dir, "multi_attr");
+    state.write(this->secParam);
+    state.write(this->attrSses.size());
+    // (the state file only gets moved into place once all attribute indexes are saved)
+    for (bigint i = 0; i < (bigint)this->attrSses.size(); i++) {
+        this->attrSses[i]->save(utils::persistence::joinPath(dir, "attr_" + std::to_string(i)));
+    }
+    state.close();
+}
+
+
+template <IsLogSrcI AttrSse>
+void MultiAttr<AttrSse>::open(const std::string& dir) {
+    this->clear();
+
+    utils::persistence::StateReader state(dir, "multi_attr");
+    this->secParam = state.readBigint();
+    bigint attrCount = state.readBigint();
+    for (bigint i = 0; i < attrCount; i++) {
+        AttrSse* attrSse = new AttrSse(this->benchmark);
+        attrSse->open(utils::persistence::joinPath(dir, "attr_" + std::to_string(i)));
+        this->attrSses.push_back(attrSse);
+    }
+}
+
+
+template <IsLogSrcI AttrSse>
+bigint MultiAttr<AttrSse>::getAttrCount() const {
+    return this->attrSses.size();
+}
+
+
+//------------------------------------------------------------------------------
+// helpers
+
+
+template <IsLogSrcI AttrSse>
+std::vector<Id> MultiAttr<AttrSse>::searchAttrIds(
+    bigint attr, const Range<Kw>& attrQuery, const Range<IdAlias>& idAliasRange
+) const {
+    std::vector<Tuple<>> results = this->attrSses[attr]->searchIdAliases(idAliasRange);
+
+    std::vector<Id> ids;
+    ids.reserve(results.size());
+    for (const Tuple<>& result : results) {
+        if (attrQuery.contains(result.getKw())) {
+            ids.push_back(result.getId());
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+
+//------------------------------------------------------------------------------
+// explicit template instantiations
+
+
+template class MultiAttr<LogSrcI<PiBas>>;
+template class MultiAttr<LogSrcI<NLogN>>;
+template class MultiAttr<LogSrcIStar>;
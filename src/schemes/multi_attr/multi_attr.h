@@ -0,0 +1,83 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "schemes/log_src_i/log_src_i_base.h"
+
+#include "utils/types/basic_types.h"
+#include "utils/types/db/db.h"
+#include "utils/types/range.h"
+#include "utils/types/tuple.h"
+
+
+// forward declare instead of include to avoid a circular include with `benchmark.h`
+struct Benchmark;
+
+
+/**
+ * multi-attribute range search on top of Log-SRC-i(*): one `AttrSse` index is built per
+ * attribute (each over the same documents, keyed by that attribute's value), and a query with one
+ * range per attribute is answered by searching each index separately and combining the ids that
+ * come back on the client (so the server only ever sees single-attribute Log-SRC-i queries).
+ *
+ * this is not an `ISse`, since queries and results have a different shape (several ranges in,
+ * ids out), but otherwise follows the same interface.
+ */
+template <IsLogSrcI AttrSse>
+class MultiAttr {
+public:
+    std::shared_ptr<Benchmark> benchmark;
+
+    MultiAttr(std::shared_ptr<Benchmark> benchmark) : benchmark(benchmark) {}
+
+    ~MultiAttr();
+
+    /**
+     * build one index per attribute, the `i`th over `attrDbs[i]`.
+     *
+     * preconditions:
+     *     - each DB in `attrDbs` must contain the same documents (by id), with that attribute's
+     *       value as keyword (and otherwise satisfy the preconditions of `AttrSse::setup()`).
+     */
+    void setup(int secParam, const std::vector<Db<Tuple<>>>& attrDbs);
+
+    /**
+     * `query` has one range per attribute; attributes whose range is `Range<Kw>::DUMMY()` aren't
+     * filtered on at all. if `isConjunctive`, the documents matching every (filtered) range are
+     * returned, otherwise those matching at least one of them.
+     *
+     * for conjunctive queries, every index is asked for its id alias range first (query 1 of
+     * Log-SRC-i), which tells us how many results each attribute has before any of them are
+     * fetched; results are then fetched starting from the most selective attribute and
+     * intersected as they come back, stopping as soon as the intersection is empty.
+     *
+     * returns: the ids of the matching documents, in ascending order (and without duplicates).
+     * if no attribute is filtered on, this is empty.
+     */
+    std::vector<Id> search(const std::vector<Range<Kw>>& query, bool isConjunctive = true) const;
+
+    void clear();
+    void save(const std::string& dir);
+    void open(const std::string& dir);
+
+    bigint getAttrCount() const;
+
+private:
+    int secParam;
+    std::vector<AttrSse*> attrSses;
+
+    //--------------------------------------------------------------------------
+    // helpers
+
+    /**
+     * fetch the results of `attrQuery` on attribute `attr`, given its id alias range from query 1.
+     *
+     * returns: the ids of those results that actually match `attrQuery` (i.e. without the false
+     * positives of Log-SRC-i's second SRC node), in ascending order and without duplicates.
+     */
+    std::vector<Id> searchAttrIds(
+        bigint attr, const Range<Kw>& attrQuery, const Range<IdAlias>& idAliasRange
+    ) const;
+};
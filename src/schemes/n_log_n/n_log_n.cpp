@@ -1,12 +1,10 @@
 #include "schemes/n_log_n/n_log_n.h"
 
 #include <algorithm>
-#include <bit>
-#include <cmath>
 #include <concepts>
-#include <cstdlib>
-#include <iostream>
-#include <unordered_set>
+#include <numeric>
+#include <span>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -15,12 +13,14 @@
 #include "schemes/n_log_n/n_log_n_server.h"
 
 #include "utils/crypto.h"
+#include "utils/int_math.h"
 #include "utils/misc.h"
+#include "utils/persistence.h"
 #include "utils/random.h"
 #include "utils/types/basic_types.h"
 #include "utils/types/db/db.h"
+#include "utils/types/enc_ind/enc_ind_dict.h"
 #include "utils/types/enc_ind/enc_ind_loc.h"
-#include "utils/types/enc_ind/enc_ind_rand.h"
 #include "utils/types/enc_ind/enc_ind_utils.h"
 #include "utils/types/ind.h"
 #include "utils/types/range.h"
@@ -56,16 +56,14 @@ void NLogN<DbTuple>::setup(int secParam, const Db<DbTuple>& db) {
     this->prfKey = utils::crypto::genKey(secParam);
     this->encKey = utils::crypto::genKey(secParam);
     
-    std::vector<EncIndLoc*> encIndLvls;
+    std::vector<EncIndLoc<Layout>*> encIndLvls;
     for (bigint lvl = 0; lvl < this->lvlCount; lvl++) {
-        EncIndLoc* encIndLvl = new EncIndLoc(this->benchmark);
+        EncIndLoc<Layout>* encIndLvl = new EncIndLoc<Layout>(this->benchmark);
         bigint bcktCountOnLvl = this->calcBcktCountOnLvl(lvl);
         bigint bcktSizeOnLvl = this->calcBcktSizeOnLvl(lvl);
         encIndLvl->init(bcktSizeOnLvl, bcktCountOnLvl);
         encIndLvls.push_back(encIndLvl);
     }
-    EncIndRand* dbKwCountsDict = new EncIndRand(this->benchmark);
-    dbKwCountsDict->init(this->size);
 
     //--------------------------------------------------------------------------
     // build index
@@ -74,25 +72,29 @@ void NLogN<DbTuple>::setup(int secParam, const Db<DbTuple>& db) {
     Ind<DbTuple> ind(db);
 
     // for each w in W
-    std::unordered_set<Range<DbKw>> uniqDbKwRanges = db.getUniqDbKwRanges();
-    for (const Range<DbKw>& dbKwRange : uniqDbKwRanges) {
-        auto iter = ind.find(dbKwRange);
-        if (iter == ind.end()) {
-            std::cerr << "Error: NLogN::setup(): DB kw range " << dbKwRange
-                      << " not found in index" << std::endl;
-            std::exit(EXIT_FAILURE);
-        }
-
-        // pad keyword list to the next power of two
-        Db<DbTuple> dbKwList = std::move(iter->second);
+    const std::vector<Range<DbKw>>& dbKwRanges = ind.getDbKwRanges();
+    // (the dictionary only ever holds one count per distinct keyword, so it's sized by |W|
+    // instead of n)
+    EncIndDict<CountEncIndLayout>* dbKwCountsDict =
+        new EncIndDict<CountEncIndLayout>(this->benchmark);
+    dbKwCountsDict->init(utils::enc_ind::calcSizeForLoadFactor(dbKwRanges.size()));
+    DbKw maxDbKw = db.getDbKwBounds().second;
+    // (reused across keywords for the shuffled order of each keyword list)
+    std::vector<bigint> dbKwListOrder;
+    for (bigint dbKwIndex = 0; dbKwIndex < (bigint)dbKwRanges.size(); dbKwIndex++) {
+        const Range<DbKw>& dbKwRange = dbKwRanges[dbKwIndex];
+
+        // pad keyword list to the next power of two (like `IDb::pad()`, but without copying the
+        // list: list indices past the end of `dbKwList` just stand for the padding dummies)
+        std::span<const DbTuple> dbKwList = ind.getDbKwList(dbKwIndex);
         bigint dbKwCount = dbKwList.size();
-        DbKw maxDbKw = db.getDbKwBounds().second;
-        dbKwList.pad(maxDbKw);
+        bigint dbKwPaddedCount = utils::int_math::ceilPow2(dbKwCount);
         // randomly permute documents associated with same keyword, i.e. shuffle within bucket
-        dbKwList.shuffle();
+        dbKwListOrder.resize(dbKwPaddedCount);
+        std::iota(dbKwListOrder.begin(), dbKwListOrder.end(), 0);
+        std::shuffle(dbKwListOrder.begin(), dbKwListOrder.end(), utils::random::RNG);
 
         // generate a single `lvl`, `pos`, and `l` for each keyword list/bucket
-        bigint dbKwPaddedCount = dbKwList.size();
         // PRF(K_1, w)
         ustring queryToken = this->genQueryToken(dbKwRange);
         // l <- Hash(PRF(K_1, w) || c), and also generate associated `lvl` and `pos`
@@ -105,35 +107,40 @@ void NLogN<DbTuple>::setup(int secParam, const Db<DbTuple>& db) {
         ustring labelDict;
         ustring ivDict = utils::crypto::genIv();
         ustring encDbKwCount = utils::crypto::padAndEncrypt(
-            this->encKey, utils::ustr::toUstr(dbKwCount), ivDict, EncIndBase::DATA_LEN - 1
+            this->encKey, utils::ustr::toUstr(dbKwCount), ivDict, CountEncIndLayout::DATA_LEN - 1
         );
         ubigint posDict = this->mapNoMod(queryToken, labelDict);
         dbKwCountsDict->writeToFirstEmpty(
-            posDict, std::pair {labelDict, std::pair {encDbKwCount, ivDict}}
+            posDict,
+            utils::enc_ind::toEncIndEntry<CountEncIndLayout>(labelDict, encDbKwCount, ivDict)
         );
 
         // for each id in DB(w) (write into same bucket consecutively)
         bigint bcktSizeOnLvl = this->calcBcktSizeOnLvl(lvl);
         ubigint startPos = pos * bcktSizeOnLvl;
         for (bigint dbKwCounter = 0; dbKwCounter < dbKwPaddedCount; dbKwCounter++) {
-            DbTuple dbTuple = dbKwList[dbKwCounter];
+            bigint dbKwListIndex = dbKwListOrder[dbKwCounter];
+            DbKw dummyDbKw = maxDbKw + 1 + (dbKwListIndex - dbKwCount);
+            DbTuple dbTuple = dbKwListIndex < dbKwCount
+                ? dbKwList[dbKwListIndex] : DbTuple::DUMMY(Range<DbKw> {dummyDbKw, dummyDbKw});
             // d <- Enc(K_2, w, id)
             ustring iv = utils::crypto::genIv();
             ustring encDbTuple = utils::crypto::padAndEncrypt(
-                this->encKey, dbTuple.toUstr(), iv, EncIndBase::DATA_LEN - 1
+                this->encKey, dbTuple.toUstr(), iv, Layout::DATA_LEN - 1
             );
             // store `(l, d)` into key-value store, and also store IV in plain along with `d`
             if (dbKwCounter == 0) {
                 // if first write to this bucket, get the first bucket start pos at or after
                 // `startPos` that is *empty* (e.g. in case of modulo collision in encrypted index)
                 encIndLvls[lvl]->writeToFirstEmpty(
-                    startPos, std::pair {label, std::pair {encDbTuple, iv}}
+                    startPos, utils::enc_ind::toEncIndEntry<Layout>(label, encDbTuple, iv)
                 );
             } else {
                 // after first write, just write consecutively as we are now guaranteed that
                 // there is a full bucket of contiguous space here
                 encIndLvls[lvl]->write(
-                    startPos + dbKwCounter, std::pair {label, std::pair {encDbTuple, iv}}
+                    startPos + dbKwCounter,
+                    utils::enc_ind::toEncIndEntry<Layout>(label, encDbTuple, iv)
                 );
             }
         }
@@ -157,20 +164,40 @@ void NLogN<DbTuple>::clear() {
 }
 
 
+template <IsDbTuple DbTuple>
+void NLogN<DbTuple>::save(const std::string& dir) {
+    utils::persistence::StateWriter state(dir, this->STATE_NAME());
+    this->saveState(state);
+    // (the state file only gets moved into place once the indexes are saved)
+    this->server->save(dir);
+    state.close();
+}
+
+
+template <IsDbTuple DbTuple>
+void NLogN<DbTuple>::open(const std::string& dir) {
+    this->clear();
+
+    utils::persistence::StateReader state(dir, this->STATE_NAME());
+    this->openState(state);
+    this->server->open(dir);
+}
+
+
 //------------------------------------------------------------------------------
 // `ISdUnderly`
 
 
 template <IsDbTuple DbTuple>
 void NLogN<DbTuple>::getDb(Db<DbTuple>& ret) const {
-    std::vector<EncIndLoc*> encIndLvls = this->server->getEncIndLvls();
+    std::vector<EncIndLoc<Layout>*> encIndLvls = this->server->getEncIndLvls();
 
     for (bigint lvl = 0; lvl < this->lvlCount; lvl++) {
-        EncIndLoc* encIndLvl = encIndLvls[lvl];
+        EncIndLoc<Layout>* encIndLvl = encIndLvls[lvl];
         // don't use `this->size` as the bound here as that doesn't include padding while
         // `encIndLvl` does (this should all be client-side anyway so not leaking anything)
         for (bigint pos = 0; pos < encIndLvl->getSize(); pos++) {
-            EncIndVal encIndVal;
+            EncIndVal<Layout> encIndVal;
             bool isValidVal = encIndLvl->read(pos, encIndVal);
             if (!isValidVal) {
                 continue;
@@ -198,51 +225,120 @@ void NLogN<DbTuple>::getDb(Db<DbTuple>& ret) const {
 
 template <IsDbTuple DbTuple>
 std::vector<DbTuple> NLogN<DbTuple>::searchBase(const Range<DbKw>& query) const {
-    std::vector<DbTuple> results {};
+    return this->searchBaseBatch(std::vector {query})[0];
+}
 
-    // PRF(K_1, w)
-    ustring queryToken = this->genQueryToken(query);
 
-    // first retrieve the number of results/`dbKwCount` to know what level to search
+template <IsDbTuple DbTuple>
+std::vector<std::vector<DbTuple>> NLogN<DbTuple>::searchBaseBatch(
+    const std::vector<Range<DbKw>>& queries
+) const {
+    // PRF(K_1, w) for every query
+    std::vector<ustring> queryTokens;
+    queryTokens.reserve(queries.size());
+    for (const Range<DbKw>& query : queries) {
+        queryTokens.push_back(this->genQueryToken(query));
+    }
+
+    // first retrieve the number of results/`dbKwCount` of every query to know what level to search
     // (and how many dummies there are)
-    ustring labelDict;
-    ubigint posDict = this->mapNoMod(queryToken, labelDict);
-    EncIndVal encIndValDict;
-    bool isFoundDict = this->server->getDbKwCount(posDict, labelDict, encIndValDict);
-    if (!isFoundDict) {
+    std::vector<std::pair<ubigint, ustring>> posesAndLabelsDict;
+    posesAndLabelsDict.reserve(queries.size());
+    for (const ustring& queryToken : queryTokens) {
+        ustring labelDict;
+        ubigint posDict = this->mapNoMod(queryToken, labelDict);
+        posesAndLabelsDict.push_back(std::pair {posDict, labelDict});
+    }
+    std::vector<EncIndVal<CountEncIndLayout>> encIndValsDict;
+    std::vector<bool> isFoundsDict = this->server->getDbKwCounts(
+        posesAndLabelsDict, encIndValsDict
+    );
+
+    std::vector<bigint> dbKwCounts(queries.size(), 0);
+    for (bigint i = 0; i < (bigint)queries.size(); i++) {
+        if (!isFoundsDict[i]) {
+            continue;
+        }
+        ustring decDbKwCount = utils::crypto::decryptAndUnpad(
+            this->encKey, encIndValsDict[i].encData.data(), CountEncIndLayout::DATA_LEN,
+            encIndValsDict[i].iv.data()
+        );
+        dbKwCounts[i] = utils::ustr::fromUstr(decDbKwCount);
+    }
+
+    return this->searchBckts(queryTokens, dbKwCounts);
+}
+
+
+//------------------------------------------------------------------------------
+// helpers
+
+
+template <IsDbTuple DbTuple>
+std::vector<std::vector<DbTuple>> NLogN<DbTuple>::searchBckts(
+    const std::vector<ustring>& queryTokens, const std::vector<bigint>& dbKwCounts
+) const {
+    std::vector<std::vector<DbTuple>> results(queryTokens.size());
+
+    // compute `lvl` and `pos` of correct bucket of each query (the same way as in `setup()`)
+    std::vector<bigint> lvls;
+    std::vector<typename NLogNServer<DbTuple>::BcktReq> bckts;
+    std::vector<bigint> bcktQueryInds;
+    for (bigint i = 0; i < (bigint)queryTokens.size(); i++) {
+        if (dbKwCounts[i] == 0) {
+            continue;
+        }
+        bigint dbKwPaddedCount = utils::int_math::ceilPow2(dbKwCounts[i]); // this is bucket size
+        ustring label;
+        std::pair<ubigint, ubigint> lvlAndPos = this->map(queryTokens[i], dbKwPaddedCount, label);
+        ubigint lvl = lvlAndPos.first;
+        ubigint pos = lvlAndPos.second;
+        // return entire bucket (`dbKwPaddedCount` instead of `dbKwCount`) from server
+        // to hide true result size
+        ubigint startPos = pos * this->calcBcktSizeOnLvl(lvl);
+        lvls.push_back(lvl);
+        bckts.push_back(typename NLogNServer<DbTuple>::BcktReq {startPos, label, dbKwPaddedCount});
+        bcktQueryInds.push_back(i);
+    }
+    if (bckts.empty()) {
         return results;
     }
-    ustring encDbKwCount = encIndValDict.first;
-    ustring ivDict = encIndValDict.second;
-    ustring decDbKwCount = utils::crypto::decryptAndUnpad(this->encKey, encDbKwCount, ivDict);
-    bigint dbKwCount = utils::ustr::fromUstr(decDbKwCount);
-    bigint dbKwPaddedCount = std::pow(2, std::ceil(std::log2(dbKwCount))); // this is bucket size
-
-    // compute `lvl` and `pos` of correct bucket (the same way as in `setup()`)
-    ustring label;
-    std::pair<ubigint, ubigint> lvlAndPos = this->map(queryToken, dbKwPaddedCount, label);
-    ubigint lvl = lvlAndPos.first;
-    ubigint pos = lvlAndPos.second;
-    // return entire bucket (`dbKwPaddedCount` instead of `dbKwCount`) from server
-    // to hide true result size
-    ubigint startPos = pos * this->calcBcktSizeOnLvl(lvl);
-    std::vector<EncIndVal> encResults = this->server->searchEncIndForBckt(
-        lvl, startPos, dbKwPaddedCount, label
+    std::vector<EncIndBuf> encResultsBufs;
+    std::vector<std::vector<EncIndValView>> encResults = this->server->searchEncIndForBckts(
+        lvls, bckts, encResultsBufs
     );
 
     // decrypt results on the client
-    results.reserve(encResults.size());
-    for (const EncIndVal& encResult : encResults) {
-        DbTuple result = this->decryptEncIndVal(encResult);
-        results.push_back(result);
+    for (bigint i = 0; i < (bigint)bckts.size(); i++) {
+        std::vector<DbTuple>& queryResults = results[bcktQueryInds[i]];
+        queryResults.reserve(encResults[i].size());
+        for (const EncIndValView& encResult : encResults[i]) {
+            queryResults.push_back(this->decryptEncIndVal(encResult));
+        }
     }
 
     return results;
 }
 
 
-//------------------------------------------------------------------------------
-// helpers
+template <IsDbTuple DbTuple>
+void NLogN<DbTuple>::saveState(utils::persistence::StateWriter& state) const {
+    state.write(this->secParam);
+    state.write(this->size);
+    state.write(this->lvlCount);
+    state.write(this->prfKey);
+    state.write(this->encKey);
+}
+
+
+template <IsDbTuple DbTuple>
+void NLogN<DbTuple>::openState(utils::persistence::StateReader& state) {
+    this->secParam = state.readBigint();
+    this->size = state.readBigint();
+    this->lvlCount = state.readBigint();
+    this->prfKey = state.readUstr();
+    this->encKey = state.readUstr();
+}
 
 
 template <IsDbTuple DbTuple>
@@ -267,7 +363,7 @@ std::pair<ubigint, ubigint> NLogN<DbTuple>::map(
     // l <- Hash(PRF(K_1, w))
     ubigint pos = this->mapNoMod(queryToken, retLabel);
     // (note bottommost level is level 0)
-    ubigint lvl = std::log2(dbKwPaddedCount);
+    ubigint lvl = utils::int_math::floorLog2(dbKwPaddedCount);
     pos %= (ubigint)this->calcBcktCountOnLvl(lvl);
     return std::pair {lvl, pos};
 }
@@ -275,20 +371,20 @@ std::pair<ubigint, ubigint> NLogN<DbTuple>::map(
 
 template <IsDbTuple DbTuple>
 bigint NLogN<DbTuple>::calcLvlCount() const {
-    return std::ceil(std::log2(this->size)) + 1;
+    return utils::int_math::ceilLog2(this->size) + 1;
 }
 
 
 template <IsDbTuple DbTuple>
 bigint NLogN<DbTuple>::calcBcktCountOnLvl(bigint lvl) const {
     // 2^{lvlCount - lvl + 1} is number of buckets on level `lvl`
-    return std::pow(2, this->lvlCount - lvl - 1);
+    return utils::int_math::pow2(this->lvlCount - lvl - 1);
 }
 
 
 template <IsDbTuple DbTuple>
 bigint NLogN<DbTuple>::calcBcktSizeOnLvl(bigint lvl) const {
-    return std::pow(2, lvl);
+    return utils::int_math::pow2(lvl);
 }
 
 
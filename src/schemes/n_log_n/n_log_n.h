@@ -1,6 +1,7 @@
 #pragma once
 
 #include <concepts>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -8,8 +9,10 @@
 #include "schemes/interfaces/static_point_sse.h"
 #include "schemes/n_log_n/n_log_n_server.h"
 
+#include "utils/persistence.h"
 #include "utils/types/basic_types.h"
 #include "utils/types/db/db.h"
+#include "utils/types/enc_ind/enc_ind_utils.h"
 #include "utils/types/range.h"
 #include "utils/types/tuple.h"
 #include "utils/types/ustring.h"
@@ -19,6 +22,8 @@ template <IsDbTuple DbTuple = Tuple<>>
 class NLogN : public IStaticPointSse<DbTuple>, public ISdUnderly<DbTuple> {
 protected:
     using DbKw = typename IStaticPointSse<DbTuple>::DbKw;
+    // (entry format of our levels)
+    using Layout = DbTupleEncIndLayout<DbTuple>;
 
 public:
     using IStaticPointSse<DbTuple>::IStaticPointSse;
@@ -30,6 +35,8 @@ public:
 
     void setup(int secParam, const Db<DbTuple>& db) override;
     void clear() override;
+    void save(const std::string& dir) override;
+    void open(const std::string& dir) override;
 
     //--------------------------------------------------------------------------
     // `ISdUnderly`
@@ -44,12 +51,33 @@ protected:
     // `IStaticPointSse`
 
     std::vector<DbTuple> searchBase(const Range<DbKw>& query) const override;
+    std::vector<std::vector<DbTuple>> searchBaseBatch(
+        const std::vector<Range<DbKw>>& queries
+    ) const override;
 
     //--------------------------------------------------------------------------
     // helpers
 
+    virtual constexpr std::string STATE_NAME() const { return "n_log_n"; }
+
+    /**
+     * write/read back this scheme's client state for `save()`/`open()` (in the same order;
+     * children with extra state should extend these).
+     */
+    virtual void saveState(utils::persistence::StateWriter& state) const;
+    virtual void openState(utils::persistence::StateReader& state);
+
     ustring genQueryToken(const Range<DbKw>& query) const;
 
+    /**
+     * the part of `searchBaseBatch()` after the number of results of each query is known:
+     * fetch the bucket of each of `queryTokens` holding `dbKwCounts` (non-padded) results from
+     * the server, and decrypt them. a count of `0` means the query has no results.
+     */
+    std::vector<std::vector<DbTuple>> searchBckts(
+        const std::vector<ustring>& queryTokens, const std::vector<bigint>& dbKwCounts
+    ) const;
+
     /**
      * generate encrypted label to store in encrypted index, and also return numerical
      * position only at which to place it in the index with no modulo for bucket count.
@@ -1,14 +1,20 @@
 #include "schemes/n_log_n/n_log_n_server.h"
 
 #include <concepts>
+#include <filesystem>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "config.h"
+
 #include "schemes/interfaces/sse_server.h"
 
 #include "utils/benchmark.h"
+#include "utils/persistence.h"
 #include "utils/types/basic_types.h"
+#include "utils/types/enc_ind/enc_ind_dict.h"
 #include "utils/types/enc_ind/enc_ind_loc.h"
-#include "utils/types/enc_ind/enc_ind_rand.h"
 #include "utils/types/enc_ind/enc_ind_utils.h"
 #include "utils/types/tuple.h"
 #include "utils/types/ustring.h"
@@ -17,15 +23,21 @@
 namespace {
 
 
-bigint calcAllEncIndLvlsBytes(const std::vector<EncIndLoc*>& encIndLvls) {
+template <class Layout>
+bigint calcAllEncIndLvlsBytes(const std::vector<EncIndLoc<Layout>*>& encIndLvls) {
     bigint bytes = 0;
-    for (EncIndLoc* encIndLvl : encIndLvls) {
-        bytes += encIndLvl->getSize() * EncIndBase::ENTRY_LEN;
+    for (EncIndLoc<Layout>* encIndLvl : encIndLvls) {
+        bytes += encIndLvl->getStorageLen();
     }
     return bytes;
 }
 
 
+std::string genEncIndLvlFilename(const std::string& dir, bigint lvl) {
+    return utils::persistence::joinPath(dir, "enc_ind_lvl_" + std::to_string(lvl) + ".dat");
+}
+
+
 } // anonymous namespace
 
 
@@ -46,9 +58,9 @@ NLogNServer<DbTuple>::~NLogNServer() {
 
 template <IsDbTuple DbTuple>
 void NLogNServer<DbTuple>::clear() {
-    for (EncIndLoc* lvl : this->encIndLvls) {
+    for (EncIndLoc<Layout>* lvl : this->encIndLvls) {
         if (lvl != nullptr) {
-            this->benchmark->serverStorage -= lvl->getSize() * EncIndBase::ENTRY_LEN;
+            this->benchmark->serverStorage -= lvl->getStorageLen();
             delete lvl;
             lvl = nullptr;
         }
@@ -56,19 +68,56 @@ void NLogNServer<DbTuple>::clear() {
     this->encIndLvls.clear();
 
     if (this->dbKwCountsDict != nullptr) {
-        this->benchmark->serverStorage -= this->dbKwCountsDict->getSize() * EncIndBase::ENTRY_LEN;
+        this->benchmark->serverStorage -=
+            this->dbKwCountsDict->getSize() * CountEncIndLayout::ENTRY_LEN;
         delete this->dbKwCountsDict;
         this->dbKwCountsDict = nullptr;
     }
 }
 
 
+template <IsDbTuple DbTuple>
+void NLogNServer<DbTuple>::save(const std::string& dir) {
+    for (bigint lvl = 0; lvl < (bigint)this->encIndLvls.size(); lvl++) {
+        this->encIndLvls[lvl]->save(::genEncIndLvlFilename(dir, lvl));
+    }
+    if (this->dbKwCountsDict != nullptr) {
+        this->dbKwCountsDict->save(utils::persistence::joinPath(dir, "enc_ind_dict.dat"));
+    }
+}
+
+
+template <IsDbTuple DbTuple>
+void NLogNServer<DbTuple>::open(const std::string& dir) {
+    this->clear();
+
+    // (levels are numbered consecutively, so just open them until we run out)
+    for (bigint lvl = 0; std::filesystem::exists(::genEncIndLvlFilename(dir, lvl)); lvl++) {
+        EncIndLoc<Layout>* encIndLvl = new EncIndLoc<Layout>(this->benchmark);
+        encIndLvl->open(::genEncIndLvlFilename(dir, lvl));
+        this->encIndLvls.push_back(encIndLvl);
+    }
+    this->benchmark->serverStorage += ::calcAllEncIndLvlsBytes(this->encIndLvls);
+
+    std::string dictFilename = utils::persistence::joinPath(dir, "enc_ind_dict.dat");
+    if (std::filesystem::exists(dictFilename)) {
+        this->dbKwCountsDict = new EncIndDict<CountEncIndLayout>(this->benchmark);
+        this->dbKwCountsDict->open(dictFilename);
+        if constexpr (config::SHOULD_KEEP_DB_KW_COUNTS_DICTS_IN_RAM) {
+            this->dbKwCountsDict->loadIntoRam();
+        }
+        this->benchmark->serverStorage +=
+            this->dbKwCountsDict->getSize() * CountEncIndLayout::ENTRY_LEN;
+    }
+}
+
+
 //------------------------------------------------------------------------------
 // helpers
 
 
 template <IsDbTuple DbTuple>
-void NLogNServer<DbTuple>::setEncIndLvls(const std::vector<EncIndLoc*>& encIndLvls) {
+void NLogNServer<DbTuple>::setEncIndLvls(const std::vector<EncIndLoc<Layout>*>& encIndLvls) {
     bigint allEncIndLvlsBytes = ::calcAllEncIndLvlsBytes(encIndLvls);
     this->benchmark->serverStorage += allEncIndLvlsBytes;
     this->benchmark->communication += allEncIndLvlsBytes;
@@ -78,7 +127,8 @@ void NLogNServer<DbTuple>::setEncIndLvls(const std::vector<EncIndLoc*>& encIndLv
 
 
 template <IsDbTuple DbTuple>
-std::vector<EncIndLoc*> NLogNServer<DbTuple>::getEncIndLvls() const {
+std::vector<EncIndLoc<typename NLogNServer<DbTuple>::Layout>*>
+NLogNServer<DbTuple>::getEncIndLvls() const {
     bigint allEncIndLvlsBytes = ::calcAllEncIndLvlsBytes(this->encIndLvls);
     this->benchmark->serverStorage += allEncIndLvlsBytes;
     this->benchmark->communication += allEncIndLvlsBytes;
@@ -88,54 +138,69 @@ std::vector<EncIndLoc*> NLogNServer<DbTuple>::getEncIndLvls() const {
 
 
 template <IsDbTuple DbTuple>
-std::vector<EncIndVal> NLogNServer<DbTuple>::searchEncIndForBckt(
-    bigint lvl, ubigint startPos, bigint bcktSize, const ustring& label
+std::vector<std::vector<EncIndValView>> NLogNServer<DbTuple>::searchEncIndForBckts(
+    const std::vector<bigint>& lvls, const std::vector<BcktReq>& bckts,
+    std::vector<EncIndBuf>& retBufs
 ) const {
-    this->benchmark->communication +=
-        sizeof(bigint) + sizeof(ubigint) + sizeof(bigint) + sizeof(bigint) + label.length();
-    std::vector<EncIndVal> encResults;
-
-    for (bigint dbKwCounter = 0; dbKwCounter < bcktSize; dbKwCounter++) {
-        EncIndVal encIndVal;
-        bool isFound;
-        if (dbKwCounter == 0) {
-            // if first read, get the right bucket start pos (e.g. in case of modulo
-            // collision in encrypted index)
-            // (note: dummies must also use the correct (not dummy) `label` so they
-            // are still found by `find()`)
-            isFound = this->encIndLvls[lvl]->find(startPos, label, encIndVal);
-        } else {
-            // after first read, just read from the bucket consecutively as we are
-            // now guaranteed that the full bucket is stored here contiguously
-            isFound = this->encIndLvls[lvl]->read(startPos + dbKwCounter, encIndVal);
+    std::vector<std::vector<EncIndValView>> encResults(bckts.size());
+    retBufs.clear();
+
+    // split up the buckets by level
+    std::vector<std::vector<bigint>> bcktIndsByLvl(this->encIndLvls.size());
+    for (bigint i = 0; i < (bigint)bckts.size(); i++) {
+        this->benchmark->communication +=
+            sizeof(bigint) + sizeof(ubigint) + sizeof(bigint) + sizeof(bigint)
+            + bckts[i].key.length();
+        bcktIndsByLvl[lvls[i]].push_back(i);
+    }
+
+    // get the right buckets (e.g. in case of modulo collision in encrypted index) on each level
+    // (note: dummies must also use the correct (not dummy) label so they are still found
+    // by `findBcktBatch()`)
+    for (bigint lvl = 0; lvl < (bigint)bcktIndsByLvl.size(); lvl++) {
+        const std::vector<bigint>& bcktInds = bcktIndsByLvl[lvl];
+        if (bcktInds.empty()) {
+            continue;
         }
-        if (!isFound) {
-            break;
+        std::vector<BcktReq> lvlBckts;
+        lvlBckts.reserve(bcktInds.size());
+        for (bigint bcktInd : bcktInds) {
+            lvlBckts.push_back(bckts[bcktInd]);
+        }
+        std::vector<std::vector<EncIndValView>> lvlEncResults;
+        this->encIndLvls[lvl]->findBcktBatch(lvlBckts, retBufs, lvlEncResults);
+        for (bigint i = 0; i < (bigint)bcktInds.size(); i++) {
+            this->benchmark->communication += lvlEncResults[i].size() * Layout::VAL_LEN;
+            encResults[bcktInds[i]] = std::move(lvlEncResults[i]);
         }
-
-        encResults.push_back(encIndVal);
     }
 
-    this->benchmark->communication += encResults.size() * EncIndBase::VAL_LEN;
     return encResults;
 }
 
 
 template <IsDbTuple DbTuple>
-void NLogNServer<DbTuple>::setDbKwCountsDict(EncIndRand* dbKwCountsDict) {
-    bigint dbKwCountsDictBytes = dbKwCountsDict->getSize() * EncIndBase::ENTRY_LEN;
+void NLogNServer<DbTuple>::setDbKwCountsDict(EncIndDict<CountEncIndLayout>* dbKwCountsDict) {
+    bigint dbKwCountsDictBytes = dbKwCountsDict->getSize() * CountEncIndLayout::ENTRY_LEN;
     this->benchmark->serverStorage += dbKwCountsDictBytes;
     this->benchmark->communication += dbKwCountsDictBytes;
     this->dbKwCountsDict = dbKwCountsDict;
+    if constexpr (config::SHOULD_KEEP_DB_KW_COUNTS_DICTS_IN_RAM) {
+        this->dbKwCountsDict->loadIntoRam();
+    }
 }
 
 
 template <IsDbTuple DbTuple>
-bool NLogNServer<DbTuple>::getDbKwCount(
-    ubigint pos, const ustring& label, EncIndVal& ret
+std::vector<bool> NLogNServer<DbTuple>::getDbKwCounts(
+    const std::vector<std::pair<ubigint, ustring>>& posesAndLabels,
+    std::vector<EncIndVal<CountEncIndLayout>>& ret
 ) const {
-    this->benchmark->communication += sizeof(ubigint) + label.length() + EncIndBase::VAL_LEN;
-    return this->dbKwCountsDict->find(pos, label, ret);
+    for (const std::pair<ubigint, ustring>& posAndLabel : posesAndLabels) {
+        this->benchmark->communication +=
+            sizeof(ubigint) + posAndLabel.second.length() + CountEncIndLayout::VAL_LEN;
+    }
+    return this->dbKwCountsDict->findBatch(posesAndLabels, ret);
 }
 
 
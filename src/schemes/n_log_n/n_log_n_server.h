@@ -1,13 +1,15 @@
 #pragma once
 
 #include <concepts>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "schemes/interfaces/sse_server.h"
 
 #include "utils/types/basic_types.h"
+#include "utils/types/enc_ind/enc_ind_dict.h"
 #include "utils/types/enc_ind/enc_ind_loc.h"
-#include "utils/types/enc_ind/enc_ind_rand.h"
 #include "utils/types/enc_ind/enc_ind_utils.h"
 #include "utils/types/tuple.h"
 #include "utils/types/ustring.h"
@@ -15,7 +17,14 @@
 
 template <IsDbTuple DbTuple = Tuple<>>
 class NLogNServer : public ISseServer<DbTuple> {
+private:
+    // (entry format of the levels; the keyword count dictionary only holds counts, so it uses
+    // the much smaller `CountEncIndLayout`)
+    using Layout = DbTupleEncIndLayout<DbTuple>;
+
 public:
+    using BcktReq = typename EncIndLoc<Layout>::BcktReq;
+
     using ISseServer<DbTuple>::ISseServer;
 
     ~NLogNServer();
@@ -24,24 +33,43 @@ public:
     // `ISseServer`
 
     void clear() override;
+    void save(const std::string& dir) override;
+    void open(const std::string& dir) override;
 
     //--------------------------------------------------------------------------
     // helpers
 
-    void setEncIndLvls(const std::vector<EncIndLoc*>& encIndLvls);
-    std::vector<EncIndLoc*> getEncIndLvls() const;
-    std::vector<EncIndVal> searchEncIndForBckt(
-        bigint lvl, ubigint startPos, bigint bcktSize, const ustring& label
+    void setEncIndLvls(const std::vector<EncIndLoc<Layout>*>& encIndLvls);
+    std::vector<EncIndLoc<Layout>*> getEncIndLvls() const;
+    /**
+     * look up each of `bckts` (in the level of the same index in `lvls`) on the server, reading
+     * each bucket in one go since buckets are stored contiguously, and buckets on the same level
+     * together (see `EncIndLoc::findBcktBatch()`).
+     *
+     * returns: views into `retBufs` (which can be reused across calls) of each bucket's entries,
+     * in the same order as `bckts` (or no entries if that bucket wasn't found).
+     */
+    std::vector<std::vector<EncIndValView>> searchEncIndForBckts(
+        const std::vector<bigint>& lvls, const std::vector<BcktReq>& bckts,
+        std::vector<EncIndBuf>& retBufs
     ) const;
 
-    void setDbKwCountsDict(EncIndRand* dbKwCountsDict);
-    bool getDbKwCount(ubigint pos, const ustring& label, EncIndVal& ret) const;
+    void setDbKwCountsDict(EncIndDict<CountEncIndLayout>* dbKwCountsDict);
+    /**
+     * look up the (encrypted) keyword counts at each of `posesAndLabels` in one go.
+     *
+     * returns: whether each was found; if so, its value is in the corresponding entry of `ret`.
+     */
+    std::vector<bool> getDbKwCounts(
+        const std::vector<std::pair<ubigint, ustring>>& posesAndLabels,
+        std::vector<EncIndVal<CountEncIndLayout>>& ret
+    ) const;
 
 protected:
-    std::vector<EncIndLoc*> encIndLvls;
+    std::vector<EncIndLoc<Layout>*> encIndLvls;
 
 private:
-    EncIndRand* dbKwCountsDict = nullptr;
+    EncIndDict<CountEncIndLayout>* dbKwCountsDict = nullptr;
 
     //--------------------------------------------------------------------------
     // helpers
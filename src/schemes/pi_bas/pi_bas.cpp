@@ -1,9 +1,9 @@
 #include "schemes/pi_bas/pi_bas.h"
 
 #include <concepts>
-#include <cstdlib>
-#include <iostream>
-#include <unordered_set>
+#include <functional>
+#include <span>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -13,9 +13,10 @@
 
 #include "utils/crypto.h"
 #include "utils/misc.h"
+#include "utils/persistence.h"
 #include "utils/types/basic_types.h"
 #include "utils/types/db/db.h"
-#include "utils/types/enc_ind/enc_ind_rand.h"
+#include "utils/types/enc_ind/enc_ind_dict.h"
 #include "utils/types/enc_ind/enc_ind_utils.h"
 #include "utils/types/ind.h"
 #include "utils/types/range.h"
@@ -50,8 +51,8 @@ void PiBas<DbTuple>::setup(int secParam, const Db<DbTuple>& db) {
     this->prfKey = utils::crypto::genKey(secParam);
     this->encKey = utils::crypto::genKey(secParam);
 
-    EncIndRand* encInd = new EncIndRand(this->benchmark);
-    encInd->init(this->size);
+    EncIndDict<Layout>* encInd = new EncIndDict<Layout>(this->benchmark);
+    encInd->init(utils::enc_ind::calcSizeForLoadFactor(this->size));
 
     //--------------------------------------------------------------------------
     // build index
@@ -62,32 +63,27 @@ void PiBas<DbTuple>::setup(int secParam, const Db<DbTuple>& db) {
     Ind<DbTuple> ind(db, true);
 
     // for each w in W
-    std::unordered_set<Range<DbKw>> uniqDbKwRanges = db.getUniqDbKwRanges();
-    for (const Range<DbKw>& dbKwRange : uniqDbKwRanges) {
-        auto iter = ind.find(dbKwRange);
-        if (iter == ind.end()) {
-            std::cerr << "Error: PiBas::setup(): DB kw range " << dbKwRange
-                      << " not found in index" << std::endl;
-            std::exit(EXIT_FAILURE);
-        }
-
+    const std::vector<Range<DbKw>>& dbKwRanges = ind.getDbKwRanges();
+    for (bigint dbKwIndex = 0; dbKwIndex < (bigint)dbKwRanges.size(); dbKwIndex++) {
         // PRF(K_1, w)
-        ustring queryToken = this->genQueryToken(dbKwRange);
-        Db<DbTuple> dbKwList = std::move(iter->second);
+        ustring queryToken = this->genQueryToken(dbKwRanges[dbKwIndex]);
+        std::span<const DbTuple> dbKwList = ind.getDbKwList(dbKwIndex);
 
         // for each id in DB(w)
-        for (bigint dbKwCounter = 0; dbKwCounter < dbKwList.size(); dbKwCounter++) {
-            DbTuple dbTuple = dbKwList[dbKwCounter];
+        for (bigint dbKwCounter = 0; dbKwCounter < (bigint)dbKwList.size(); dbKwCounter++) {
+            const DbTuple& dbTuple = dbKwList[dbKwCounter];
             // l <- Hash(PRF(K_1, w) || c), and also generate associated `pos`
             ustring label;
             ubigint pos = this->map(queryToken, dbKwCounter, label);
             // d <- Enc(K_2, w, id)
             ustring iv = utils::crypto::genIv();
             ustring encDbTuple = utils::crypto::padAndEncrypt(
-                this->encKey, dbTuple.toUstr(), iv, EncIndBase::DATA_LEN - 1
+                this->encKey, dbTuple.toUstr(), iv, Layout::DATA_LEN - 1
             );
             // store `(l, d)` into key-value store, and also store IV in plain along with `d`
-            encInd->writeToFirstEmpty(pos, std::pair {label, std::pair {encDbTuple, iv}});
+            encInd->writeToFirstEmpty(
+                pos, utils::enc_ind::toEncIndEntry<Layout>(label, encDbTuple, iv)
+            );
         }
     }
 
@@ -108,18 +104,45 @@ void PiBas<DbTuple>::clear() {
 }
 
 
+template <IsDbTuple DbTuple>
+void PiBas<DbTuple>::save(const std::string& dir) {
+    utils::persistence::StateWriter state(dir, "pi_bas");
+    state.write(this->secParam);
+    state.write(this->size);
+    state.write(this->prfKey);
+    state.write(this->encKey);
+    // (the state file only gets moved into place once the indexes are saved)
+    this->server->save(dir);
+    state.close();
+}
+
+
+template <IsDbTuple DbTuple>
+void PiBas<DbTuple>::open(const std::string& dir) {
+    this->clear();
+
+    utils::persistence::StateReader state(dir, "pi_bas");
+    this->secParam = state.readBigint();
+    this->size = state.readBigint();
+    this->prfKey = state.readUstr();
+    this->encKey = state.readUstr();
+
+    this->server->open(dir);
+}
+
+
 //------------------------------------------------------------------------------
 // `ISdUnderly`
 
 
 template <IsDbTuple DbTuple>
 void PiBas<DbTuple>::getDb(Db<DbTuple>& ret) const {
-    EncIndRand* encInd = this->server->getEncInd();
+    EncIndDict<Layout>* encInd = this->server->getEncInd();
 
     // don't use `this->size` as the bound here as that doesn't include padding while
     // `encInd` does (this should all be client-side anyway so not leaking anything)
     for (bigint pos = 0; pos < encInd->getSize(); pos++) {
-        EncIndVal encIndVal;
+        EncIndVal<Layout> encIndVal;
         bool isValidVal = encInd->read(pos, encIndVal);
         if (!isValidVal) {
             continue;
@@ -141,22 +164,52 @@ void PiBas<DbTuple>::getDb(Db<DbTuple>& ret) const {
 template <IsDbTuple DbTuple>
 std::vector<DbTuple> PiBas<DbTuple>::searchBase(const Range<DbKw>& query) const {
     std::vector<DbTuple> results;
+    this->searchBaseEach(query, [&](const DbTuple& result) { results.push_back(result); });
+    return results;
+}
 
-    // PRF(K_1, w)
-    ustring queryToken = this->genQueryToken(query);
-    std::vector<EncIndVal> encResults = this->server->searchEncInd(queryToken);
 
-    // decrypt results on the client
-    results.reserve(encResults.size());
-    for (const EncIndVal& encResult : encResults) {
-        DbTuple result = this->decryptEncIndVal(encResult);
-        results.push_back(result);
+template <IsDbTuple DbTuple>
+std::vector<std::vector<DbTuple>> PiBas<DbTuple>::searchBaseBatch(
+    const std::vector<Range<DbKw>>& queries
+) const {
+    // PRF(K_1, w) for every query
+    std::vector<ustring> queryTokens;
+    queryTokens.reserve(queries.size());
+    for (const Range<DbKw>& query : queries) {
+        queryTokens.push_back(this->genQueryToken(query));
     }
+    std::vector<std::vector<EncIndVal<Layout>>> encResults =
+        this->server->searchEncIndBatch(queryTokens);
 
+    // decrypt results on the client
+    std::vector<std::vector<DbTuple>> results(queries.size());
+    for (bigint i = 0; i < (bigint)queries.size(); i++) {
+        results[i].reserve(encResults[i].size());
+        for (const EncIndVal<Layout>& encResult : encResults[i]) {
+            results[i].push_back(this->decryptEncIndVal(encResult));
+        }
+    }
     return results;
 }
 
 
+template <IsDbTuple DbTuple>
+void PiBas<DbTuple>::searchBaseEach(
+    const Range<DbKw>& query, const std::function<void(const DbTuple&)>& onResult
+) const {
+    // PRF(K_1, w)
+    ustring queryToken = this->genQueryToken(query);
+
+    // decrypt results on the client as each batch comes back from the server
+    this->server->searchEncInd(queryToken, [&](const std::vector<EncIndVal<Layout>>& encResults) {
+        for (const EncIndVal<Layout>& encResult : encResults) {
+            onResult(this->decryptEncIndVal(encResult));
+        }
+    });
+}
+
+
 //------------------------------------------------------------------------------
 // helpers
 
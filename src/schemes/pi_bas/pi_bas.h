@@ -1,6 +1,8 @@
 #pragma once
 
 #include <concepts>
+#include <functional>
+#include <string>
 #include <vector>
 
 #include "schemes/interfaces/sd_underly.h"
@@ -9,6 +11,7 @@
 
 #include "utils/types/basic_types.h"
 #include "utils/types/db/db.h"
+#include "utils/types/enc_ind/enc_ind_utils.h"
 #include "utils/types/range.h"
 #include "utils/types/tuple.h"
 #include "utils/types/ustring.h"
@@ -20,6 +23,8 @@ template <IsDbTuple DbTuple = Tuple<>>
 class PiBas : public IStaticPointSse<DbTuple>, public ISdUnderly<DbTuple> {
 private:
     using DbKw = typename IStaticPointSse<DbTuple>::DbKw;
+    // (entry format of our encrypted index)
+    using Layout = DbTupleEncIndLayout<DbTuple>;
 
 public:
     using IStaticPointSse<DbTuple>::IStaticPointSse;
@@ -31,6 +36,8 @@ public:
 
     void setup(int secParam, const Db<DbTuple>& db) override;
     void clear() override;
+    void save(const std::string& dir) override;
+    void open(const std::string& dir) override;
 
     //--------------------------------------------------------------------------
     // `ISdUnderly`
@@ -44,6 +51,12 @@ private:
     // `IStaticPointSse`
 
     std::vector<DbTuple> searchBase(const Range<DbKw>& query) const override;
+    std::vector<std::vector<DbTuple>> searchBaseBatch(
+        const std::vector<Range<DbKw>>& queries
+    ) const override;
+    void searchBaseEach(
+        const Range<DbKw>& query, const std::function<void(const DbTuple&)>& onResult
+    ) const override;
 
     //--------------------------------------------------------------------------
     // helpers
@@ -1,20 +1,131 @@
 #include "schemes/pi_bas/pi_bas_server.h"
 
+#include <algorithm>
 #include <concepts>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include "config.h"
+
 #include "schemes/interfaces/sse_server.h"
 
 #include "utils/benchmark.h"
 #include "utils/crypto.h"
 #include "utils/misc.h"
+#include "utils/persistence.h"
 #include "utils/types/basic_types.h"
-#include "utils/types/enc_ind/enc_ind_rand.h"
+#include "utils/types/enc_ind/enc_ind_dict.h"
 #include "utils/types/enc_ind/enc_ind_utils.h"
 #include "utils/types/tuple.h"
 #include "utils/types/ustring.h"
 
 
+namespace {
+
+
+/**
+ * the one long-lived thread that pipelined PiBas searches hand the fetching of their later
+ * batches to, so that a search doesn't pay for starting a thread (and setting up that thread's
+ * io_uring ring) every time.
+ */
+class FetchWorker {
+public:
+    FetchWorker() : thread([this] { this->work(); }) {}
+
+    ~FetchWorker() {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->isStopping = true;
+        }
+        this->cv.notify_all();
+        this->thread.join();
+    }
+
+    /**
+     * run `job` on the worker if it's idle.
+     *
+     * returns in `retDone`: a future that becomes ready once `job` has finished.
+     *
+     * returns: whether `job` was handed off (`false` if the worker is still busy with another one).
+     */
+    bool trySubmit(std::function<void()> job, std::future<void>& retDone) {
+        std::packaged_task<void()> task(std::move(job));
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (this->isBusy) {
+                return false;
+            }
+            this->isBusy = true;
+            retDone = task.get_future();
+            this->task = std::move(task);
+        }
+        this->cv.notify_all();
+        return true;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::packaged_task<void()> task;
+    bool isBusy = false;
+    bool isStopping = false;
+    // (declared last so that everything it uses is initialized before it starts)
+    std::thread thread;
+
+    void work() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (true) {
+            this->cv.wait(lock, [this] { return this->task.valid() || this->isStopping; });
+            if (!this->task.valid()) {
+                return;
+            }
+            std::packaged_task<void()> task = std::move(this->task);
+            lock.unlock();
+            task();
+            lock.lock();
+            this->isBusy = false;
+        }
+    }
+};
+
+
+FetchWorker& getFetchWorker() {
+    static FetchWorker worker;
+    return worker;
+}
+
+
+/**
+ * runs `onExit` when it goes out of scope.
+ */
+template <std::invocable F>
+class ScopeGuard {
+public:
+    explicit ScopeGuard(F onExit) : onExit(std::move(onExit)) {}
+    ScopeGuard(const ScopeGuard&) = delete;
+    ScopeGuard& operator=(const ScopeGuard&) = delete;
+
+    ~ScopeGuard() {
+        this->onExit();
+    }
+
+private:
+    F onExit;
+};
+
+
+} // anonymous namespace
+
+
 template <IsDbTuple DbTuple>
 PiBasServer<DbTuple>::~PiBasServer() {
     this->clear();
@@ -31,20 +142,42 @@ void PiBasServer<DbTuple>::clear() {
     // pointer assignment, so if we don't delete we would make this memory inaccessible
     // the next time we assign `encInd`)
     if (this->encInd != nullptr) {
-        this->benchmark->serverStorage -= this->encInd->getSize() * EncIndBase::ENTRY_LEN;
+        this->benchmark->serverStorage -= this->encInd->getSize() * Layout::ENTRY_LEN;
         delete this->encInd;
         this->encInd = nullptr;
     };
 }
 
 
+template <IsDbTuple DbTuple>
+void PiBasServer<DbTuple>::save(const std::string& dir) {
+    // (nothing to save if we were cleared, e.g. an emptied SDa subindex)
+    if (this->encInd != nullptr) {
+        this->encInd->save(utils::persistence::joinPath(dir, "enc_ind.dat"));
+    }
+}
+
+
+template <IsDbTuple DbTuple>
+void PiBasServer<DbTuple>::open(const std::string& dir) {
+    this->clear();
+
+    std::string encIndFilename = utils::persistence::joinPath(dir, "enc_ind.dat");
+    if (std::filesystem::exists(encIndFilename)) {
+        this->encInd = new EncIndDict<Layout>(this->benchmark);
+        this->encInd->open(encIndFilename);
+        this->benchmark->serverStorage += this->encInd->getSize() * Layout::ENTRY_LEN;
+    }
+}
+
+
 //------------------------------------------------------------------------------
 // helpers
 
 
 template <IsDbTuple DbTuple>
-void PiBasServer<DbTuple>::setEncInd(EncIndRand* encInd) {
-    bigint encIndBytes = encInd->getSize() * EncIndBase::ENTRY_LEN;
+void PiBasServer<DbTuple>::setEncInd(EncIndDict<Layout>* encInd) {
+    bigint encIndBytes = encInd->getSize() * Layout::ENTRY_LEN;
     this->benchmark->serverStorage += encIndBytes;
     this->benchmark->communication += encIndBytes;
     this->encInd = encInd;
@@ -52,40 +185,225 @@ void PiBasServer<DbTuple>::setEncInd(EncIndRand* encInd) {
 
 
 template <IsDbTuple DbTuple>
-EncIndRand* PiBasServer<DbTuple>::getEncInd() const {
-    this->benchmark->communication += this->encInd->getSize() * EncIndBase::ENTRY_LEN;
+EncIndDict<typename PiBasServer<DbTuple>::Layout>* PiBasServer<DbTuple>::getEncInd() const {
+    this->benchmark->communication += this->encInd->getSize() * Layout::ENTRY_LEN;
     return this->encInd;
 }
 
 
 template <IsDbTuple DbTuple>
-std::vector<EncIndVal> PiBasServer<DbTuple>::searchEncInd(const ustring& queryToken) const {
+void PiBasServer<DbTuple>::searchEncInd(
+    const ustring& queryToken,
+    const std::function<void(const std::vector<EncIndVal<Layout>>&)>& onBatch
+) const {
     this->benchmark->communication += queryToken.length();
-    std::vector<EncIndVal> encResults;
 
     // for c = 0 until `Get` returns error
-    bigint dbKwCounter = 0;
+    // (we look up `config::PI_BAS_SEARCH_BATCH_SIZE` consecutive labels at a time so that the
+    // encrypted index can have all of their reads in flight together)
+    std::vector<EncIndVal<Layout>> encResults;
+    bool hasMore = this->fetchBatch(queryToken, 0, encResults);
+    bigint resultCount = encResults.size();
+    onBatch(encResults);
+    if (!hasMore) {
+        this->benchmark->communication += resultCount * Layout::VAL_LEN;
+        return;
+    }
+
+    // fetches and hands over the remaining batches one after another on this thread
+    auto searchRestHere = [&] {
+        for (bigint dbKwCounter = config::PI_BAS_SEARCH_BATCH_SIZE; hasMore;
+                dbKwCounter += config::PI_BAS_SEARCH_BATCH_SIZE) {
+            hasMore = this->fetchBatch(queryToken, dbKwCounter, encResults);
+            resultCount += encResults.size();
+            onBatch(encResults);
+        }
+        this->benchmark->communication += resultCount * Layout::VAL_LEN;
+    };
+
+    if constexpr (!config::SHOULD_PIPELINE_PI_BAS_SEARCH) {
+        searchRestHere();
+        return;
+    }
+
+    // the first batch was full, so there may be a lot more: have the fetch worker fetch the rest,
+    // queueing up batches for the caller to consume while it's still working on earlier ones
+    // (only handed off now so that the common case of a single batch doesn't pay for it)
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::vector<EncIndVal<Layout>>> fetchedBatches;
+    bool isFetchingDone = false;
+    bool isCancelled = false;
+
+    auto fetchRest = [&] {
+        bool hasMoreToFetch = true;
+        for (bigint dbKwCounter = config::PI_BAS_SEARCH_BATCH_SIZE; hasMoreToFetch;
+                dbKwCounter += config::PI_BAS_SEARCH_BATCH_SIZE) {
+            std::vector<EncIndVal<Layout>> batch;
+            hasMoreToFetch = this->fetchBatch(queryToken, dbKwCounter, batch);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] {
+                return (bigint)fetchedBatches.size() < config::PI_BAS_SEARCH_PIPELINE_DEPTH
+                       || isCancelled;
+            });
+            if (isCancelled) {
+                break;
+            }
+            fetchedBatches.push_back(std::move(batch));
+            isFetchingDone = !hasMoreToFetch;
+            cv.notify_all();
+        }
+    };
+
+    // if the worker is already busy (another search, or a search started from inside `onBatch`),
+    // don't queue up behind it; just fetch the rest here without pipelining
+    std::future<void> fetchDone;
+    if (!getFetchWorker().trySubmit(fetchRest, fetchDone)) {
+        searchRestHere();
+        return;
+    }
+
+    // make sure the worker is done with our locals before they go out of scope, even if
+    // `onBatch` throws
+    ScopeGuard fetchGuard([&] {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isCancelled = true;
+        }
+        cv.notify_all();
+        fetchDone.wait();
+    });
+
     while (true) {
-        // l <- Hash(PRF(K_1, w) || c), and also generate associated `pos`
-        // (same as client's `setup()`)
-        ustring label = utils::crypto::hash(queryToken + utils::ustr::toUstr(dbKwCounter));
-        ubigint pos = utils::misc::hashToPos(label);
-        // res <- encInd.get(l)
-        EncIndVal encIndVal;
-        bool isFound = this->encInd->find(pos, label, encIndVal);
-        if (!isFound) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return !fetchedBatches.empty() || isFetchingDone; });
+        if (fetchedBatches.empty()) {
             break;
         }
+        encResults = std::move(fetchedBatches.front());
+        fetchedBatches.pop_front();
+        cv.notify_all();
+        lock.unlock();
 
-        encResults.push_back(encIndVal);
-        dbKwCounter++;
+        resultCount += encResults.size();
+        onBatch(encResults);
     }
 
-    this->benchmark->communication += encResults.size() * EncIndBase::VAL_LEN;
+    this->benchmark->communication += resultCount * Layout::VAL_LEN;
+}
+
+
+template <IsDbTuple DbTuple>
+std::vector<std::vector<EncIndVal<typename PiBasServer<DbTuple>::Layout>>>
+PiBasServer<DbTuple>::searchEncIndBatch(
+    const std::vector<ustring>& queryTokens
+) const {
+    std::vector<std::vector<EncIndVal<Layout>>> encResults(queryTokens.size());
+    bigint resultCount = 0;
+    std::vector<bigint> activeInds;
+    activeInds.reserve(queryTokens.size());
+    for (bigint i = 0; i < (bigint)queryTokens.size(); i++) {
+        this->benchmark->communication += queryTokens[i].length();
+        activeInds.push_back(i);
+    }
+
+    // for c = 0 until `Get` returns error (for each query)
+    for (bigint dbKwCounter = 0; !activeInds.empty();
+            dbKwCounter += config::PI_BAS_SEARCH_BATCH_SIZE) {
+        bigint labelCount = activeInds.size() * config::PI_BAS_SEARCH_BATCH_SIZE;
+        std::vector<std::pair<ubigint, ustring>> posesAndLabels;
+        posesAndLabels.reserve(labelCount);
+        for (bigint activeInd : activeInds) {
+            for (bigint i = 0; i < config::PI_BAS_SEARCH_BATCH_SIZE; i++) {
+                // l <- Hash(PRF(K_1, w) || c), and also generate associated `pos`
+                // (same as client's `setup()`)
+                ustring label = utils::crypto::hash(
+                    queryTokens[activeInd] + utils::ustr::toUstr(dbKwCounter + i)
+                );
+                ubigint pos = utils::misc::hashToPos(label);
+                posesAndLabels.push_back(std::pair {pos, label});
+            }
+        }
+
+        // look all of the labels up in one go, in order of position so that the reads for
+        // different queries that land near each other in the index are issued together
+        std::vector<bigint> order(labelCount);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](bigint i1, bigint i2) {
+            return posesAndLabels[i1].first < posesAndLabels[i2].first;
+        });
+        std::vector<std::pair<ubigint, ustring>> sortedPosesAndLabels;
+        sortedPosesAndLabels.reserve(labelCount);
+        std::vector<bigint> sortedInds(labelCount);
+        for (bigint i = 0; i < labelCount; i++) {
+            sortedPosesAndLabels.push_back(std::move(posesAndLabels[order[i]]));
+            sortedInds[order[i]] = i;
+        }
+        // res <- encInd.get(l)
+        std::vector<EncIndVal<Layout>> sortedEncIndVals;
+        std::vector<bool> sortedIsFounds = this->encInd->findBatch(
+            sortedPosesAndLabels, sortedEncIndVals
+        );
+
+        // queries that found their whole batch may have more results in the next one
+        std::vector<bigint> nextActiveInds;
+        for (bigint j = 0; j < (bigint)activeInds.size(); j++) {
+            bool isDone = false;
+            for (bigint i = 0; i < config::PI_BAS_SEARCH_BATCH_SIZE; i++) {
+                bigint sortedInd = sortedInds[j * config::PI_BAS_SEARCH_BATCH_SIZE + i];
+                if (!sortedIsFounds[sortedInd]) {
+                    isDone = true;
+                    break;
+                }
+                encResults[activeInds[j]].push_back(std::move(sortedEncIndVals[sortedInd]));
+                resultCount++;
+            }
+            if (!isDone) {
+                nextActiveInds.push_back(activeInds[j]);
+            }
+        }
+        activeInds = std::move(nextActiveInds);
+    }
+
+    this->benchmark->communication += resultCount * Layout::VAL_LEN;
     return encResults;
 }
 
 
+//------------------------------------------------------------------------------
+// helpers
+
+
+template <IsDbTuple DbTuple>
+bool PiBasServer<DbTuple>::fetchBatch(
+    const ustring& queryToken, bigint dbKwCounter, std::vector<EncIndVal<Layout>>& ret
+) const {
+    std::vector<std::pair<ubigint, ustring>> posesAndLabels;
+    posesAndLabels.reserve(config::PI_BAS_SEARCH_BATCH_SIZE);
+    for (bigint i = 0; i < config::PI_BAS_SEARCH_BATCH_SIZE; i++) {
+        // l <- Hash(PRF(K_1, w) || c), and also generate associated `pos`
+        // (same as client's `setup()`)
+        ustring label = utils::crypto::hash(queryToken + utils::ustr::toUstr(dbKwCounter + i));
+        ubigint pos = utils::misc::hashToPos(label);
+        posesAndLabels.push_back(std::pair {pos, label});
+    }
+
+    // res <- encInd.get(l)
+    // (counters are consecutive, so nothing after the first label that's missing can be there)
+    std::vector<EncIndVal<Layout>> encIndVals;
+    std::vector<bool> isFounds = this->encInd->findBatch(posesAndLabels, encIndVals, true);
+    ret.clear();
+    for (bigint i = 0; i < config::PI_BAS_SEARCH_BATCH_SIZE; i++) {
+        if (!isFounds[i]) {
+            return false;
+        }
+        ret.push_back(encIndVals[i]);
+    }
+    return true;
+}
+
+
 //------------------------------------------------------------------------------
 // explicit template instantiations
 
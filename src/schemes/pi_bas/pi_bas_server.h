@@ -1,12 +1,14 @@
 #pragma once
 
 #include <concepts>
+#include <functional>
+#include <string>
 #include <vector>
 
 #include "schemes/interfaces/sse_server.h"
 
 #include "utils/types/basic_types.h"
-#include "utils/types/enc_ind/enc_ind_rand.h"
+#include "utils/types/enc_ind/enc_ind_dict.h"
 #include "utils/types/enc_ind/enc_ind_utils.h"
 #include "utils/types/tuple.h"
 #include "utils/types/ustring.h"
@@ -14,6 +16,10 @@
 
 template <IsDbTuple DbTuple = Tuple<>>
 class PiBasServer : public ISseServer<DbTuple> {
+private:
+    // (entry format of the encrypted index)
+    using Layout = DbTupleEncIndLayout<DbTuple>;
+
 public:
     using ISseServer<DbTuple>::ISseServer;
 
@@ -23,14 +29,51 @@ public:
     // `ISseServer`
 
     void clear() override;
+    void save(const std::string& dir) override;
+    void open(const std::string& dir) override;
 
     //--------------------------------------------------------------------------
     // helpers
 
-    void setEncInd(EncIndRand* encInd);
-    EncIndRand* getEncInd() const;
-    std::vector<EncIndVal> searchEncInd(const ustring& queryToken) const;
+    void setEncInd(EncIndDict<Layout>* encInd);
+    EncIndDict<Layout>* getEncInd() const;
+    /**
+     * hands the results for `queryToken` to `onBatch` a batch (of up to
+     * `config::PI_BAS_SEARCH_BATCH_SIZE`) at a time, in order. if
+     * `config::SHOULD_PIPELINE_PI_BAS_SEARCH`, later batches are fetched on a shared worker thread
+     * (when it's free) while `onBatch` is still busy with earlier ones.
+     */
+    void searchEncInd(
+        const ustring& queryToken,
+        const std::function<void(const std::vector<EncIndVal<Layout>>&)>& onBatch
+    ) const;
+
+    /**
+     * batched version of `searchEncInd()` for several queries at once: each round looks up the
+     * next batch of labels of every query that isn't done yet together, sorted by position.
+     *
+     * returns: the results of each query, in the same order as `queryTokens`.
+     */
+    std::vector<std::vector<EncIndVal<Layout>>> searchEncIndBatch(
+        const std::vector<ustring>& queryTokens
+    ) const;
 
 private:
-    EncIndRand* encInd = nullptr;
+    EncIndDict<Layout>* encInd = nullptr;
+
+    //--------------------------------------------------------------------------
+    // helpers
+
+    /**
+     * look up the `config::PI_BAS_SEARCH_BATCH_SIZE` labels starting at counter `dbKwCounter`.
+     *
+     * returns in `ret`: the values found, up to the first label that wasn't found.
+     *
+     * returns:
+     *     - `true` if every label in the batch was found (so the next batch may have more).
+     *     - `false` if this was the last batch.
+     */
+    bool fetchBatch(
+        const ustring& queryToken, bigint dbKwCounter, std::vector<EncIndVal<Layout>>& ret
+    ) const;
 };
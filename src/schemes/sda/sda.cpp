@@ -2,7 +2,9 @@
 
 #include <algorithm>
 #include <concepts>
-#include <cmath>
+#include <span>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "schemes/interfaces/sd_underly.h"
@@ -14,7 +16,9 @@
 #include "schemes/n_log_n/n_log_n.h"
 #include "schemes/pi_bas/pi_bas.h"
 
+#include "utils/int_math.h"
 #include "utils/misc.h"
+#include "utils/persistence.h"
 #include "utils/types/basic_types.h"
 #include "utils/types/db/db.h"
 #include "utils/types/range.h"
@@ -43,7 +47,7 @@ void Sda<Underly>::setup(int secParam, const Db<Tuple<>>& db) {
             return;
         }
 
-        bigint lastFilledInd = std::log2(db.size());
+        bigint lastFilledInd = utils::int_math::floorLog2(db.size());
 
         // this is the shortcut way: simply initialize and fill in all subindexes in one go
         // (note that the non-shortcut `setup()` places earlier items in `db` into larger
@@ -51,7 +55,7 @@ void Sda<Underly>::setup(int secParam, const Db<Tuple<>>& db) {
         // in `db` up the largest subindexes first (this was needed anyway))
         bigint dbPos = 0;
         for (bigint i = lastFilledInd; i >= 0; i--) {
-            bigint indSize = (bigint)std::pow(2, i);
+            bigint indSize = utils::int_math::pow2(i);
             Db<Tuple<>> indDb;
             if (dbPos < db.size()) {
                 if (dbPos + indSize < db.size()) {
@@ -64,7 +68,7 @@ void Sda<Underly>::setup(int secParam, const Db<Tuple<>>& db) {
             }
 
             Underly* newUnderly = new Underly(this->benchmark);
-            newUnderly->setup(this->secParam, indDb);
+            newUnderly->setup(this->secParam, std::move(indDb));
             this->underlys.push_back(newUnderly);
             dbPos += indSize;
         }
@@ -107,6 +111,33 @@ std::vector<Tuple<>> Sda<Underly>::search(
 }
 
 
+template <IsSdUnderly Underly>
+std::vector<std::vector<Tuple<>>> Sda<Underly>::searchBatch(
+    std::span<const Range<Kw>> queries, bool shouldCleanUpResults, bool isNaive
+) const {
+    std::vector<std::vector<Tuple<>>> allResults(queries.size());
+
+    // search through all non-empty indexes, each for all queries at once
+    for (Underly* underly : this->underlys) {
+        if (underly->getSize() == 0) {
+            continue;
+        }
+        // (don't clean up in underlying schemes; see `search()`)
+        std::vector<std::vector<Tuple<>>> results = underly->searchBatch(queries, false, isNaive);
+        for (bigint i = 0; i < (bigint)queries.size(); i++) {
+            allResults[i].insert(allResults[i].end(), results[i].begin(), results[i].end());
+        }
+    }
+
+    if (shouldCleanUpResults) {
+        for (std::vector<Tuple<>>& results : allResults) {
+            results = utils::misc::cleanUpResults(results);
+        }
+    }
+    return allResults;
+}
+
+
 template <IsSdUnderly Underly>
 void Sda<Underly>::clear() {
     // (apparently vector `clear()` automatically calls the destructor for each element
@@ -126,6 +157,38 @@ void Sda<Underly>::clear() {
 }
 
 
+template <IsSdUnderly Underly>
+void Sda<Underly>::save(const std::string& dir) {
+    utils::persistence::StateWriter state(dir, "sda");
+    state.write(this->secParam);
+    state.write(this->updateCount);
+    state.write(this->firstEmptyInd);
+    state.write(this->underlys.size());
+    // (the state file only gets moved into place once all subindexes are saved)
+    for (bigint i = 0; i < (bigint)this->underlys.size(); i++) {
+        this->underlys[i]->save(utils::persistence::joinPath(dir, "underly_" + std::to_string(i)));
+    }
+    state.close();
+}
+
+
+template <IsSdUnderly Underly>
+void Sda<Underly>::open(const std::string& dir) {
+    this->clear();
+
+    utils::persistence::StateReader state(dir, "sda");
+    this->secParam = state.readBigint();
+    this->updateCount = state.readBigint();
+    this->firstEmptyInd = state.readBigint();
+    bigint underlyCount = state.readBigint();
+    for (bigint i = 0; i < underlyCount; i++) {
+        Underly* underly = new Underly(this->benchmark);
+        underly->open(utils::persistence::joinPath(dir, "underly_" + std::to_string(i)));
+        this->underlys.push_back(underly);
+    }
+}
+
+
 //------------------------------------------------------------------------------
 // `IDsse`
 
@@ -152,10 +215,10 @@ void Sda<Underly>::update(const Tuple<>& newTuple) {
     if (this->firstEmptyInd >= this->underlys.size() - 1) {
         // if we need to create a new, larger index
         Underly* newUnderly = new Underly(this->benchmark);
-        newUnderly->setup(this->secParam, mergedDb);
+        newUnderly->setup(this->secParam, std::move(mergedDb));
         this->underlys.push_back(newUnderly);
     } else {
-        this->underlys[this->firstEmptyInd]->setup(this->secParam, mergedDb);
+        this->underlys[this->firstEmptyInd]->setup(this->secParam, std::move(mergedDb));
     }
 
     // clear all EDB_<j
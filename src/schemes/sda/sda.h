@@ -1,6 +1,8 @@
 #pragma once
 
 #include <concepts>
+#include <span>
+#include <string>
 #include <vector>
 
 #include "schemes/interfaces/dsse.h"
@@ -32,7 +34,12 @@ public:
     std::vector<Tuple<>> search(
         const Range<Kw>& query, bool shouldCleanUpResults = true, bool isNaive = true
     ) const override;
+    std::vector<std::vector<Tuple<>>> searchBatch(
+        std::span<const Range<Kw>> queries, bool shouldCleanUpResults = true, bool isNaive = true
+    ) const override;
     void clear() override;
+    void save(const std::string& dir) override;
+    void open(const std::string& dir) override;
 
     //--------------------------------------------------------------------------
     // `IDsse`
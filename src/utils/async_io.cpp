@@ -0,0 +1,387 @@
+#include "utils/async_io.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define HAS_IO_URING
+#endif
+
+#include "config.h"
+
+#include "utils/types/basic_types.h"
+
+
+namespace {
+
+
+using utils::async_io::IoReq;
+
+
+/**
+ * do (the rest of) `req` with blocking syscalls, starting from `doneLen` bytes in.
+ */
+void doBlockingIo(const IoReq& req, bigint doneLen = 0) {
+    // (`pread()`/`pwrite()` may do fewer bytes than asked for, so keep going until we're done)
+    while (doneLen < req.len) {
+        ssize_t res;
+        if (req.isWrite) {
+            res = ::pwrite(
+                req.fd, static_cast<const char*>(req.buf) + doneLen, req.len - doneLen,
+                req.offset + doneLen
+            );
+        } else {
+            res = ::pread(
+                req.fd, static_cast<char*>(req.buf) + doneLen, req.len - doneLen,
+                req.offset + doneLen
+            );
+        }
+        if (res <= 0) {
+            std::cerr << "Error: utils::async_io::doBlockingIo(): error "
+                      << (req.isWrite ? "writing" : "reading") << " fd " << req.fd << " (only did "
+                      << doneLen << " out of " << req.len << " bytes)" << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        doneLen += res;
+    }
+}
+
+
+//==============================================================================
+// `IoThreadPool`
+//==============================================================================
+
+
+/**
+ * fallback for when io_uring isn't available: a fixed set of threads that pick requests off
+ * of the current batch and do them with blocking syscalls (one batch at a time).
+ */
+class IoThreadPool {
+public:
+    IoThreadPool(int threadCount) {
+        for (int i = 0; i < threadCount; i++) {
+            this->threads.emplace_back([this] { this->work(); });
+        }
+    }
+
+    ~IoThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->isStopping = true;
+        }
+        this->workCv.notify_all();
+        for (std::thread& thread : this->threads) {
+            thread.join();
+        }
+    }
+
+    void run(std::vector<IoReq>& reqs) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->idleCv.wait(lock, [this] { return this->batch == nullptr; });
+
+        this->batch = &reqs;
+        this->nextIndex = 0;
+        this->remainingCount = reqs.size();
+        this->workCv.notify_all();
+        this->doneCv.wait(lock, [this] { return this->remainingCount == 0; });
+
+        this->batch = nullptr;
+        this->idleCv.notify_one();
+    }
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable workCv;
+    std::condition_variable doneCv;
+    std::condition_variable idleCv;
+
+    std::vector<IoReq>* batch = nullptr;
+    bigint nextIndex = 0;
+    bigint remainingCount = 0;
+    bool isStopping = false;
+
+    void work() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (true) {
+            this->workCv.wait(lock, [this] {
+                return this->isStopping
+                    || (this->batch != nullptr && this->nextIndex < (bigint)this->batch->size());
+            });
+            if (this->isStopping) {
+                return;
+            }
+
+            const IoReq& req = (*this->batch)[this->nextIndex];
+            this->nextIndex++;
+            lock.unlock();
+            doBlockingIo(req);
+            lock.lock();
+
+            this->remainingCount--;
+            if (this->remainingCount == 0) {
+                this->doneCv.notify_all();
+            }
+        }
+    }
+};
+
+
+IoThreadPool& getThreadPool() {
+    static IoThreadPool pool(std::min<int>(
+        config::ASYNC_IO_QUEUE_DEPTH, std::max(4u, 2 * std::thread::hardware_concurrency())
+    ));
+    return pool;
+}
+
+
+//==============================================================================
+// `IoUring`
+//==============================================================================
+
+
+#ifdef HAS_IO_URING
+
+
+/**
+ * minimal io_uring wrapper using the raw syscalls (so we don't need liburing), which submits
+ * a batch of reads/writes with one `io_uring_enter()` and then reaps their completions.
+ */
+class IoUring {
+public:
+    IoUring() = default;
+
+    ~IoUring() {
+        if (this->sqes != nullptr) {
+            ::munmap(this->sqes, this->sqesLen);
+        }
+        if (this->cqRing != nullptr && this->cqRing != this->sqRing) {
+            ::munmap(this->cqRing, this->cqRingLen);
+        }
+        if (this->sqRing != nullptr) {
+            ::munmap(this->sqRing, this->sqRingLen);
+        }
+        if (this->ringFd >= 0) {
+            ::close(this->ringFd);
+        }
+    }
+
+    IoUring(const IoUring& other) = delete;
+    IoUring& operator =(const IoUring& other) = delete;
+
+    /**
+     * returns: `false` if io_uring is not usable here (in which case this should not be used).
+     */
+    bool init(unsigned entryCount) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        this->ringFd = ::syscall(__NR_io_uring_setup, entryCount, &params);
+        if (this->ringFd < 0) {
+            return false;
+        }
+        this->entryCount = params.sq_entries;
+
+        // map submission and completion rings (which share one mapping on newer kernels)
+        this->sqRingLen = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        this->cqRingLen = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool isSingleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (isSingleMmap) {
+            this->sqRingLen = this->cqRingLen = std::max(this->sqRingLen, this->cqRingLen);
+        }
+        this->sqRing = this->mapRing(this->sqRingLen, IORING_OFF_SQ_RING);
+        if (this->sqRing == nullptr) {
+            return false;
+        }
+        if (isSingleMmap) {
+            this->cqRing = this->sqRing;
+        } else {
+            this->cqRing = this->mapRing(this->cqRingLen, IORING_OFF_CQ_RING);
+            if (this->cqRing == nullptr) {
+                return false;
+            }
+        }
+        this->sqesLen = params.sq_entries * sizeof(io_uring_sqe);
+        this->sqes = static_cast<io_uring_sqe*>(this->mapRing(this->sqesLen, IORING_OFF_SQES));
+        if (this->sqes == nullptr) {
+            return false;
+        }
+
+        char* sq = static_cast<char*>(this->sqRing);
+        this->sqTail  = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        this->sqMask  = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        this->sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(this->cqRing);
+        this->cqHead  = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        this->cqTail  = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        this->cqMask  = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        this->cqes    = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    void run(std::vector<IoReq>& reqs) {
+        // (submit in chunks of at most the ring size)
+        bigint reqCount = reqs.size();
+        for (bigint chunkStart = 0; chunkStart < reqCount; chunkStart += this->entryCount) {
+            unsigned chunkSize = std::min<bigint>(this->entryCount, reqCount - chunkStart);
+
+            unsigned tail = *this->sqTail;
+            for (unsigned i = 0; i < chunkSize; i++) {
+                const IoReq& req = reqs[chunkStart + i];
+                unsigned index = tail & *this->sqMask;
+                io_uring_sqe* sqe = &this->sqes[index];
+                std::memset(sqe, 0, sizeof(io_uring_sqe));
+                sqe->opcode = req.isWrite ? IORING_OP_WRITE : IORING_OP_READ;
+                sqe->fd = req.fd;
+                sqe->addr = reinterpret_cast<ubigint>(req.buf);
+                sqe->len = req.len;
+                sqe->off = req.offset;
+                sqe->user_data = chunkStart + i;
+                this->sqArray[index] = index;
+                tail++;
+            }
+            std::atomic_ref<unsigned>(*this->sqTail).store(tail, std::memory_order_release);
+
+            unsigned toSubmit = chunkSize;
+            unsigned completedCount = 0;
+            while (completedCount < chunkSize) {
+                int res = ::syscall(
+                    __NR_io_uring_enter, this->ringFd, toSubmit, 1, IORING_ENTER_GETEVENTS,
+                    nullptr, 0
+                );
+                if (res < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    std::cerr << "Error: utils::async_io::IoUring::run(): io_uring_enter() failed ("
+                              << std::strerror(errno) << ")" << std::endl;
+                    std::exit(EXIT_FAILURE);
+                }
+                toSubmit -= res;
+                completedCount += this->reapCompletions(reqs);
+            }
+        }
+    }
+
+private:
+    int ringFd = -1;
+    unsigned entryCount = 0;
+    void* sqRing = nullptr;
+    void* cqRing = nullptr;
+    io_uring_sqe* sqes = nullptr;
+    bigint sqRingLen = 0;
+    bigint cqRingLen = 0;
+    bigint sqesLen = 0;
+
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    void* mapRing(bigint len, ubigint offset) {
+        void* ring = ::mmap(
+            nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ringFd, offset
+        );
+        return ring != MAP_FAILED ? ring : nullptr;
+    }
+
+    /**
+     * returns: number of completions reaped.
+     */
+    unsigned reapCompletions(std::vector<IoReq>& reqs) {
+        unsigned reapedCount = 0;
+        unsigned head = *this->cqHead;
+        unsigned tail = std::atomic_ref<unsigned>(*this->cqTail).load(std::memory_order_acquire);
+        for (; head != tail; head++) {
+            const io_uring_cqe& cqe = this->cqes[head & *this->cqMask];
+            const IoReq& req = reqs[cqe.user_data];
+            // finish short reads/writes ourselves, and also do the whole request ourselves if the
+            // kernel doesn't support this opcode or this file for async I/O
+            if (cqe.res >= 0) {
+                doBlockingIo(req, cqe.res);
+            } else if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP || cqe.res == -EAGAIN
+                    || cqe.res == -EINTR) {
+                doBlockingIo(req);
+            } else {
+                std::cerr << "Error: utils::async_io::IoUring::reapCompletions(): error "
+                          << (req.isWrite ? "writing" : "reading") << " fd " << req.fd << " ("
+                          << std::strerror(-cqe.res) << ")" << std::endl;
+                std::exit(EXIT_FAILURE);
+            }
+            reapedCount++;
+        }
+        std::atomic_ref<unsigned>(*this->cqHead).store(head, std::memory_order_release);
+
+        return reapedCount;
+    }
+};
+
+
+/**
+ * returns: this thread's ring, or `nullptr` if io_uring isn't usable.
+ */
+IoUring* getThreadRing() {
+    thread_local std::unique_ptr<IoUring> ring = [] {
+        auto newRing = std::make_unique<IoUring>();
+        if (!newRing->init(config::ASYNC_IO_QUEUE_DEPTH)) {
+            newRing.reset();
+        }
+        return newRing;
+    }();
+    return ring.get();
+}
+
+
+#endif
+
+
+} // anonymous namespace
+
+
+//==============================================================================
+// `utils::async_io`
+//==============================================================================
+
+
+namespace utils::async_io {
+
+
+void submitAndWait(std::vector<IoReq>& reqs) {
+    if (reqs.empty()) {
+        return;
+    }
+    // (not worth the overhead for a single request)
+    if (reqs.size() == 1) {
+        doBlockingIo(reqs[0]);
+        return;
+    }
+
+#ifdef HAS_IO_URING
+    IoUring* ring = getThreadRing();
+    if (ring != nullptr) {
+        ring->run(reqs);
+        return;
+    }
+#endif
+
+    getThreadPool().run(reqs);
+}
+
+
+} // namespace `utils::async_io`
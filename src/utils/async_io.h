@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+#include "utils/types/basic_types.h"
+
+
+namespace utils::async_io {
+
+
+/**
+ * a single positional read or write of `len` bytes at `offset` in file descriptor `fd`.
+ */
+struct IoReq {
+    int fd = -1;
+    void* buf = nullptr;
+    bigint len = 0;
+    bigint offset = 0;
+    bool isWrite = false;
+};
+
+
+/**
+ * submit all of `reqs` at once and block until every one of them has fully completed.
+ *
+ * this uses io_uring where available (one ring per thread, set up on first use), so that all
+ * of `reqs` are in flight at the same time; otherwise (e.g. old kernels, or io_uring disabled
+ * by seccomp) it falls back to a shared thread pool doing blocking `pread()`s/`pwrite()`s.
+ * exits on I/O errors like the rest of the disk storage code.
+ */
+void submitAndWait(std::vector<IoReq>& reqs);
+
+
+} // namespace `utils::async_io`
@@ -6,9 +6,12 @@
 #include <format>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "config.h"
+
 #include "schemes/interfaces/dsse.h"
 #include "schemes/interfaces/sse.h"
 
@@ -44,7 +47,8 @@ public:
     // profiling specific pieces of code
 
     // IMPORTANT: this does not currently work with nested profilings on the same `benchmark`
-    // object and profile!
+    // object and profile (or the same profile running on several threads at once; that won't
+    // corrupt anything, but the overlapping times will be off)!
     struct Profile {
         double time = 0;
         std::chrono::time_point<std::chrono::high_resolution_clock> start;
@@ -57,8 +61,25 @@ public:
     // (this is a `map` instead of an `unordered_map` since it's probably slightly faster
     // at small scales like these, and plus the ordering is a nice bonus)
     std::map<std::string, Profile> profiles;
+    // (encrypted index reads can be profiled from PiBas's pipelined search worker at the same time
+    // as from the searching thread, so every access to `profiles` goes through this if that's on)
+    mutable std::mutex profilesMutex;
+
+    /**
+     * returns: a lock on `this->profilesMutex` if profiles may be touched by several threads at
+     * once (i.e. `config::SHOULD_PIPELINE_PI_BAS_SEARCH`), otherwise an empty one, so that
+     * single-threaded benchmarks don't pay for locking inside their timed regions.
+     */
+    std::unique_lock<std::mutex> lockProfiles() const {
+        if constexpr (config::SHOULD_PIPELINE_PI_BAS_SEARCH) {
+            return std::unique_lock<std::mutex>(this->profilesMutex);
+        } else {
+            return std::unique_lock<std::mutex>();
+        }
+    }
 
     void startProfile(const std::string& profileName) {
+        std::unique_lock<std::mutex> lock = this->lockProfiles();
         auto iter = this->profiles.find(profileName);
         if (iter != this->profiles.end()) {
             iter->second.start = std::chrono::high_resolution_clock::now();
@@ -71,6 +92,7 @@ public:
 
     void stopProfile(const std::string& profileName) {
         auto end = std::chrono::high_resolution_clock::now();
+        std::unique_lock<std::mutex> lock = this->lockProfiles();
 
         auto iter = this->profiles.find(profileName);
         if (iter != this->profiles.end()) {
@@ -85,6 +107,7 @@ public:
     }
 
     void resetProfile(const std::string& profileName) {
+        std::unique_lock<std::mutex> lock = this->lockProfiles();
         auto iter = this->profiles.find(profileName);
         if (iter != this->profiles.end()) {
             iter->second.reset();
@@ -103,6 +126,7 @@ public:
         this->totalUpdtTime = 0;
         this->totalUpdtCommunication = 0;
 
+        std::unique_lock<std::mutex> lock = this->lockProfiles();
         this->profiles.clear();
     }
 
@@ -111,6 +135,7 @@ public:
         this->communication = 0;
 
         // reset profiles (but do not clear `this->profiles`, for speed and since it makes sense)
+        std::unique_lock<std::mutex> lock = this->lockProfiles();
         for (auto& profilePair : this->profiles) {
             // bypass slower `resetProfile()` method here
             profilePair.second.reset();
@@ -144,6 +169,7 @@ public:
     void print(bool shouldBenchmark, const std::string& label) const {
         if (shouldBenchmark) {
             std::string profileOutputs = "";
+            std::unique_lock<std::mutex> lock = this->lockProfiles();
             for (const auto& profilePair : this->profiles) {
                 std::string profileName = profilePair.first;
                 Profile profile = profilePair.second;
@@ -26,6 +26,18 @@ void handleErrors() {
 }
 
 
+// IVs (which aren't secret, unlike keys) are handed out from a per-thread buffer of random bytes
+// that is refilled with one `RAND_bytes()` call at a time, instead of one call per IV
+constexpr int IV_POOL_LEN = 4096;
+
+struct IvPool {
+    uchar buf[IV_POOL_LEN];
+    int pos = IV_POOL_LEN;
+};
+
+thread_local IvPool ivPool;
+
+
 } // anonymous namespace
 
 
@@ -50,13 +62,28 @@ ustring genKey(int keyLen) {
 
 
 ustring genIv(int ivLen) {
-    uchar* iv = new uchar[ivLen];
-    int res = RAND_bytes(iv, ivLen);
-    if (res != 1) {
-        handleErrors();
-    }
-    ustring ustrIv = ::utils::ustr::toUstr(iv, ivLen);
-    delete[] iv;
+    // (too long to come from the pool, so just get it directly)
+    if (ivLen > ::IV_POOL_LEN) {
+        uchar* iv = new uchar[ivLen];
+        int res = RAND_bytes(iv, ivLen);
+        if (res != 1) {
+            handleErrors();
+        }
+        ustring ustrIv = ::utils::ustr::toUstr(iv, ivLen);
+        delete[] iv;
+        return ustrIv;
+    }
+
+    ::IvPool& pool = ::ivPool;
+    if (pool.pos + ivLen > ::IV_POOL_LEN) {
+        int res = RAND_bytes(pool.buf, ::IV_POOL_LEN);
+        if (res != 1) {
+            handleErrors();
+        }
+        pool.pos = 0;
+    }
+    ustring ustrIv = ::utils::ustr::toUstr(pool.buf + pool.pos, ivLen);
+    pool.pos += ivLen;
     return ustrIv;
 }
 
@@ -155,27 +182,35 @@ ustring padAndEncrypt(
 ustring decrypt(
     const ustring& key, const ustring& ctext, const ustring& iv, const EVP_CIPHER* cipher
 ) {
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) {
-        handleErrors();
-    }
-
-    // initialize decryption
     const uchar* ucharIv;
     if (iv == ustring()) {
         ucharIv = nullptr;
     } else {
         ucharIv = &iv[0];
     }
-    if (EVP_DecryptInit_ex(ctx, cipher, nullptr, &key[0], ucharIv) != 1) {
+    return decrypt(key, ctext.c_str(), ctext.length(), ucharIv, cipher);
+}
+
+
+ustring decrypt(
+    const ustring& key, const uchar* ctext, int ctextLen, const uchar* iv,
+    const EVP_CIPHER* cipher
+) {
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    if (!ctx) {
+        handleErrors();
+    }
+
+    // initialize decryption
+    if (EVP_DecryptInit_ex(ctx, cipher, nullptr, &key[0], iv) != 1) {
         handleErrors();
     }
 
     // perform decryption
     int ptextLen1, ptextLen2;
     ustring ptext;
-    ptext.resize(ctext.length());
-    if (EVP_DecryptUpdate(ctx, &ptext[0], &ptextLen1, &ctext[0], ctext.length()) != 1) {
+    ptext.resize(ctextLen);
+    if (EVP_DecryptUpdate(ctx, &ptext[0], &ptextLen1, ctext, ctextLen) != 1) {
         handleErrors();
     }
 
@@ -199,4 +234,14 @@ ustring decryptAndUnpad(
 }
 
 
+ustring decryptAndUnpad(
+    const ustring& key, const uchar* ctext, int ctextLen, const uchar* iv,
+    const EVP_CIPHER* cipher
+) {
+    ustring ptext = decrypt(key, ctext, ctextLen, iv, cipher);
+    utils::misc::unpadStr(ptext);
+    return ptext;
+}
+
+
 } // namespace `utils::crypto`
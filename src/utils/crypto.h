@@ -49,6 +49,15 @@ ustring decrypt(
     const EVP_CIPHER* cipher = ENC_CIPHER
 );
 
+/**
+ * same as above, but decrypting `ctextLen` bytes straight out of e.g. an encrypted index
+ * entry or read buffer (`iv` may be `nullptr` for no IV), without copying them first.
+ */
+ustring decrypt(
+    const ustring& key, const uchar* ctext, int ctextLen, const uchar* iv,
+    const EVP_CIPHER* cipher = ENC_CIPHER
+);
+
 /**
  * remove trailing padding generated by `padAndEncrypt()` after decrypting.
  */
@@ -56,6 +65,10 @@ ustring decryptAndUnpad(
     const ustring& key, const ustring& ctext, const ustring& iv,
     const EVP_CIPHER* cipher = ENC_CIPHER
 );
+ustring decryptAndUnpad(
+    const ustring& key, const uchar* ctext, int ctextLen, const uchar* iv,
+    const EVP_CIPHER* cipher = ENC_CIPHER
+);
 
 
 } // namespace `utils::crypto`
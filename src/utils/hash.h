@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+#include "utils/types/basic_types.h"
+
+
+//==============================================================================
+// `utils::hash`
+//==============================================================================
+
+
+// fast (non-cryptographic) hashes for `std::hash` specializations, so that things like `Range`s
+// and tuples can be hashed straight from their integer fields (in the style of wyhash) instead of
+// by formatting them into strings first
+namespace utils::hash {
+
+
+inline constexpr ubigint SECRET_0 = 0xa0761d6478bd642full;
+inline constexpr ubigint SECRET_1 = 0xe7037ed1a0b428dbull;
+inline constexpr ubigint SECRET_2 = 0x8ebc6af09c88c6e3ull;
+inline constexpr ubigint SECRET_3 = 0x589965cc75374cc3ull;
+
+
+/**
+ * returns: the xor of the high and low halves of the full 128-bit product of `a` and `b`.
+ */
+inline ubigint mix(ubigint a, ubigint b) {
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return static_cast<ubigint>(product) ^ static_cast<ubigint>(product >> 64);
+}
+
+
+/**
+ * returns: hash of the integer (or enum) fields `vals` together.
+ */
+template <class ... Ts>
+inline std::size_t hashInts(Ts ... vals) {
+    ubigint h = SECRET_0;
+    ((h = mix(static_cast<ubigint>(vals) ^ SECRET_1, h ^ SECRET_0)), ...);
+    return mix(h ^ sizeof...(Ts), SECRET_3);
+}
+
+
+/**
+ * returns: hash of the `len` bytes at `data` (e.g. a fixed-length label), taken 8 bytes at a time.
+ */
+inline std::size_t hashBytes(const void* data, std::size_t len) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    ubigint h = SECRET_0 ^ len;
+    std::size_t i = 0;
+    for (; i + sizeof(ubigint) <= len; i += sizeof(ubigint)) {
+        ubigint word;
+        std::memcpy(&word, bytes + i, sizeof(ubigint));
+        h = mix(word ^ SECRET_1, h ^ SECRET_0);
+    }
+    if (i < len) {
+        ubigint word = 0;
+        std::memcpy(&word, bytes + i, len - i);
+        h = mix(word ^ SECRET_2, h ^ SECRET_0);
+    }
+    return mix(h, SECRET_3);
+}
+
+
+} // namespace `utils::hash`
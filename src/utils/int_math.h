@@ -0,0 +1,66 @@
+#pragma once
+
+#include <bit>
+
+#include "utils/types/basic_types.h"
+
+
+//==============================================================================
+// `utils::int_math`
+//==============================================================================
+
+
+// exact integer versions of the power of two/log arithmetic used for NLogN's level and bucket
+// geometry (and TDAG sizes), since going through `std::pow()`/`std::log2()` on doubles is
+// slower and can round wrongly once sizes get past 2^53
+namespace utils::int_math {
+
+
+/**
+ * returns: 2^`exp`.
+ *
+ * preconditions:
+ *     - `0 <= exp <= 62`.
+ */
+constexpr bigint pow2(bigint exp) {
+    return bigint {1} << exp;
+}
+
+
+/**
+ * returns: floor(log_2(`n`)), i.e. the index of the highest set bit of `n`.
+ *
+ * preconditions:
+ *     - `n >= 1`.
+ */
+constexpr bigint floorLog2(bigint n) {
+    return std::bit_width((ubigint)n) - 1;
+}
+
+
+/**
+ * returns: ceil(log_2(`n`)), i.e. the exponent of the smallest power of two at least `n`
+ * (and `0` for `n <= 1`).
+ */
+constexpr bigint ceilLog2(bigint n) {
+    return n <= 1 ? 0 : std::bit_width((ubigint)n - 1);
+}
+
+
+/**
+ * returns: the smallest power of two at least `n` (and `1` for `n <= 1`).
+ */
+constexpr bigint ceilPow2(bigint n) {
+    return pow2(ceilLog2(n));
+}
+
+
+// (these are exact by construction, but check the edges anyway, all the way up to 2^62)
+static_assert(pow2(0) == 1 && pow2(62) == 0x4000000000000000);
+static_assert(floorLog2(1) == 0 && floorLog2(pow2(62)) == 62 && floorLog2(pow2(62) - 1) == 61);
+static_assert(ceilLog2(0) == 0 && ceilLog2(1) == 0 && ceilLog2(2) == 1 && ceilLog2(3) == 2);
+static_assert(ceilLog2(pow2(53) + 1) == 54 && ceilLog2(pow2(62)) == 62);
+static_assert(ceilLog2(pow2(61) + 1) == 62 && ceilPow2(pow2(61) + 1) == pow2(62));
+
+
+} // namespace `utils::int_math`
@@ -0,0 +1,180 @@
+#include "utils/persistence.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+#include "utils/types/basic_types.h"
+#include "utils/types/ustring.h"
+
+
+namespace {
+
+
+const std::string STATE_FILENAME = "state.dat";
+const char STATE_MAGIC[8] = {'S', 'S', 'E', 'S', 'T', 'A', 'T', 'E'};
+
+
+} // anonymous namespace
+
+
+namespace utils::persistence {
+
+
+std::string joinPath(const std::string& dir, const std::string& name) {
+    return (std::filesystem::path(dir) / name).string();
+}
+
+
+//==============================================================================
+// `StateWriter`
+//==============================================================================
+
+
+StateWriter::StateWriter(const std::string& dir, const std::string& schemeName) {
+    try {
+        std::filesystem::create_directories(dir);
+    } catch (const std::filesystem::filesystem_error& e) {
+        std::cerr << "Error: StateWriter::StateWriter(): error creating path " << dir << ": "
+                  << e.what() << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    this->filename = joinPath(dir, ::STATE_FILENAME);
+    this->tmpFilename = this->filename + ".tmp";
+    this->file = std::fopen(this->tmpFilename.c_str(), "wb");
+    if (this->file == nullptr) {
+        std::cerr << "Error: StateWriter::StateWriter(): error opening file " << this->tmpFilename
+                  << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    this->writeBytes(::STATE_MAGIC, sizeof(::STATE_MAGIC));
+    this->write((bigint)STATE_FORMAT_VERSION);
+    this->write(utils::ustr::toUstr(schemeName));
+}
+
+
+StateWriter::~StateWriter() {
+    this->close();
+}
+
+
+void StateWriter::write(bigint n) {
+    this->writeBytes(&n, sizeof(bigint));
+}
+
+
+void StateWriter::write(const ustring& ustr) {
+    this->write((bigint)ustr.length());
+    this->writeBytes(ustr.c_str(), ustr.length());
+}
+
+
+void StateWriter::close() {
+    if (this->file == nullptr) {
+        return;
+    }
+
+    if (std::fflush(this->file) != 0 || ::fsync(::fileno(this->file)) != 0) {
+        std::cerr << "Error: StateWriter::close(): error syncing file " << this->tmpFilename
+                  << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    std::fclose(this->file);
+    this->file = nullptr;
+
+    try {
+        std::filesystem::rename(this->tmpFilename, this->filename);
+    } catch (const std::filesystem::filesystem_error& e) {
+        std::cerr << "Error: StateWriter::close(): error moving file " << this->tmpFilename
+                  << " to " << this->filename << ": " << e.what() << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+void StateWriter::writeBytes(const void* buf, bigint len) {
+    if (len > 0 && std::fwrite(buf, len, 1, this->file) != 1) {
+        std::cerr << "Error: StateWriter::writeBytes(): error writing to file "
+                  << this->tmpFilename << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+//==============================================================================
+// `StateReader`
+//==============================================================================
+
+
+StateReader::StateReader(const std::string& dir, const std::string& schemeName) {
+    this->filename = joinPath(dir, ::STATE_FILENAME);
+    this->file = std::fopen(this->filename.c_str(), "rb");
+    if (this->file == nullptr) {
+        std::cerr << "Error: StateReader::StateReader(): error opening file " << this->filename
+                  << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    char magic[sizeof(::STATE_MAGIC)];
+    this->readBytes(magic, sizeof(magic));
+    if (std::memcmp(magic, ::STATE_MAGIC, sizeof(magic)) != 0) {
+        std::cerr << "Error: StateReader::StateReader(): " << this->filename << " is not a "
+                  << "saved client state file" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    bigint formatVersion = this->readBigint();
+    if (formatVersion != STATE_FORMAT_VERSION) {
+        std::cerr << "Error: StateReader::StateReader(): " << this->filename << " has format "
+                  << "version " << formatVersion << " (want " << STATE_FORMAT_VERSION << ")"
+                  << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    std::string savedSchemeName = utils::ustr::toStr(this->readUstr());
+    if (savedSchemeName != schemeName) {
+        std::cerr << "Error: StateReader::StateReader(): " << this->filename << " was saved by "
+                  << savedSchemeName << " (want " << schemeName << ")" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+StateReader::~StateReader() {
+    if (this->file != nullptr) {
+        std::fclose(this->file);
+        this->file = nullptr;
+    }
+}
+
+
+bigint StateReader::readBigint() {
+    bigint n;
+    this->readBytes(&n, sizeof(bigint));
+    return n;
+}
+
+
+ustring StateReader::readUstr() {
+    bigint len = this->readBigint();
+    ustring ustr(len, 0);
+    this->readBytes(ustr.data(), len);
+    return ustr;
+}
+
+
+void StateReader::readBytes(void* buf, bigint len) {
+    if (len > 0 && std::fread(buf, len, 1, this->file) != 1) {
+        std::cerr << "Error: StateReader::readBytes(): error reading from file " << this->filename
+                  << " (file too short?)" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+
+} // namespace `utils::persistence`
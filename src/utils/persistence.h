@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+#include "utils/types/basic_types.h"
+#include "utils/types/ustring.h"
+
+
+namespace utils::persistence {
+
+
+// (bump this whenever the layout of client state files changes)
+inline constexpr ubigint STATE_FORMAT_VERSION = 1;
+
+
+/**
+ * returns: path of `name` inside the directory `dir`.
+ */
+std::string joinPath(const std::string& dir, const std::string& name);
+
+
+//==============================================================================
+// `StateWriter`
+//==============================================================================
+
+
+/**
+ * writes the client state file of a scheme saved with `ISse::save()` into `dir` (creating it if
+ * needed): a header (magic, format version, and which scheme wrote it), then the scheme's fields
+ * in whatever order it writes them, which `StateReader` must read them back in.
+ *
+ * the file is written under a temporary name and only moved into place by `close()`, so a crash
+ * midway never leaves behind a half-written state file.
+ */
+class StateWriter {
+public:
+    StateWriter(const std::string& dir, const std::string& schemeName);
+    ~StateWriter();
+
+    StateWriter(const StateWriter& other) = delete;
+    StateWriter& operator =(const StateWriter& other) = delete;
+
+    void write(bigint n);
+    void write(const ustring& ustr);
+
+    /**
+     * finish writing and move the state file into place.
+     */
+    void close();
+
+private:
+    FILE* file = nullptr;
+    std::string filename;
+    std::string tmpFilename;
+
+    void writeBytes(const void* buf, bigint len);
+};
+
+
+//==============================================================================
+// `StateReader`
+//==============================================================================
+
+
+/**
+ * reads back a client state file written by `StateWriter` from `dir`, exiting if it isn't one,
+ * is from a different format version, or was written by a scheme other than `schemeName`.
+ */
+class StateReader {
+public:
+    StateReader(const std::string& dir, const std::string& schemeName);
+    ~StateReader();
+
+    StateReader(const StateReader& other) = delete;
+    StateReader& operator =(const StateReader& other) = delete;
+
+    bigint readBigint();
+    ustring readUstr();
+
+private:
+    FILE* file = nullptr;
+    std::string filename;
+
+    void readBytes(void* buf, bigint len);
+};
+
+
+} // namespace `utils::persistence`
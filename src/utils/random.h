@@ -3,15 +3,6 @@
 #include <random>
 
 
-namespace {
-
-
-std::random_device RAND_DEV;
-
-
-} // anonymous namespace
-
-
 //==============================================================================
 // `utils::random`
 //==============================================================================
@@ -20,7 +11,12 @@ std::random_device RAND_DEV;
 namespace utils::random {
 
 
-inline std::mt19937 RNG(RAND_DEV());
+// (non-cryptographic) RNG for things like shuffles and random filenames; each thread gets its own,
+// separately seeded one, so this can be used from multiple threads at once without locks
+inline thread_local std::mt19937 RNG = [] {
+    std::random_device randDev;
+    return std::mt19937(randDev());
+}();
 
 
 } // namespace `utils::random`
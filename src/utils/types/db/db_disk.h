@@ -9,7 +9,6 @@
 
 #include "utils/types/basic_types.h"
 #include "utils/types/db/i_db.h"
-#include "utils/types/enc_ind/enc_ind_base.h"
 #include "utils/types/i_disk_storage.h"
 #include "utils/types/range.h"
 #include "utils/types/tuple.h"
@@ -80,7 +79,7 @@ private:
     constexpr std::string FILE_DIR() const override { return "out/client"; }
     constexpr std::string FILENAME_PREFIX() const override { return "db_"; }
 
-    inline static const int TUPLE_LEN = EncIndBase::DATA_LEN;
+    inline static constexpr int TUPLE_LEN = DbTuple::MAX_STR_LEN;
 
     //--------------------------------------------------------------------------
     // helpers
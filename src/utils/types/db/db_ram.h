@@ -69,4 +69,19 @@ public:
 
 private:
     InnerType vec;
+
+    //--------------------------------------------------------------------------
+    // iterator
+
+public:
+    // (these hide `IDb`'s iterators, which have to construct each `DbTuple` on the fly, so that
+    // iterating over a `DbRam` gives references to the tuples it stores instead of copies;
+    // they're always const since tuples can only be changed through `IDb`'s methods)
+    InnerType::const_iterator begin() const {
+        return this->vec.cbegin();
+    }
+
+    InnerType::const_iterator end() const {
+        return this->vec.cend();
+    }
 };
@@ -1,10 +1,10 @@
 #include "utils/types/db/i_db.h"
 
 #include <bit>
-#include <cmath>
 #include <concepts>
 #include <unordered_set>
 
+#include "utils/int_math.h"
 #include "utils/types/basic_types.h"
 #include "utils/types/range.h"
 #include "utils/types/tuple.h"
@@ -37,7 +37,7 @@ template <IsDbTuple DbTuple>
 void IDb<DbTuple>::pad(DbKw& currMaxDbKw) {
     bigint dbSize = this->_size;
     if (!std::has_single_bit((ubigint)dbSize)) {
-        bigint amountToPad = std::pow(2, std::ceil(std::log2(dbSize))) - dbSize;
+        bigint amountToPad = utils::int_math::ceilPow2(dbSize) - dbSize;
         this->reserve(this->_size + amountToPad);
         for (bigint i = 0; i < amountToPad; i++) {
             currMaxDbKw++;
@@ -1,41 +1,77 @@
 #include "utils/types/enc_ind/enc_ind_base.h"
 
+#include <algorithm>
+#include <bit>
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <filesystem>
 #include <iostream>
 #include <memory>
+#include <span>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include <unistd.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "config.h"
+
+#include "utils/async_io.h"
 #include "utils/benchmark.h"
+#include "utils/crypto.h"
 #include "utils/debugging.h"
 #include "utils/types/basic_types.h"
+#include "utils/types/enc_ind/enc_ind_utils.h"
 #include "utils/types/i_disk_storage.h"
+#include "utils/types/tuple.h"
 #include "utils/types/ustring.h"
 
 
 // this initializes `NULL_ENTRY` to a contiguous block of zero bits
 // (technically it is possible that some encrypted tuple happened to be all `0` bytes
 // and thus get mistaken for a null kv pair, but currently `ENTRY_LEN` is in the
-// thousands of bits so there's a 2^{>1000} chance of this happening...and USENIX'24's
-// implementation seems to just do this too)
-const uchar EncIndBase::NULL_ENTRY[ENTRY_LEN] = {};
+// hundreds of bits even for the smallest layout, so there's a 2^{>500} chance of this
+// happening...and USENIX'24's implementation seems to just do this too)
+template <class Layout>
+const uchar EncIndBase<Layout>::NULL_ENTRY[ENTRY_LEN] = {};
 
 
 //------------------------------------------------------------------------------
 // constructors/destructors
 
 
-EncIndBase::EncIndBase(std::shared_ptr<Benchmark> benchmark) : benchmark(benchmark) {}
+template <class Layout>
+EncIndBase<Layout>::EncIndBase(std::shared_ptr<Benchmark> benchmark) : benchmark(benchmark) {}
 
 
 //------------------------------------------------------------------------------
 // the big five
 
 
+// destructor
+template <class Layout>
+EncIndBase<Layout>::~EncIndBase() {
+    // (done here rather than just in `~IDiskStorage()` so that our file goes back into the pool,
+    // since `FILE_POOL_CAPACITY()` is no longer overridden by the time that runs)
+    this->clear();
+}
+
+
 // copy constructor
-EncIndBase::EncIndBase(const EncIndBase& other) {
+template <class Layout>
+EncIndBase<Layout>::EncIndBase(const EncIndBase& other) {
     IDiskStorage::copyFrom(other);
+    this->size = other.size;
+    this->benchmark = other.benchmark;
+    this->isTombstoneFree = other.isTombstoneFree;
+    this->occupancyBitmap = other.occupancyBitmap;
+    this->occupancyUnitLen = other.occupancyUnitLen;
 }
 
 
@@ -43,89 +79,121 @@ EncIndBase::EncIndBase(const EncIndBase& other) {
 // interface
 
 
-void EncIndBase::init(bigint size) {
+template <class Layout>
+void EncIndBase<Layout>::init(bigint size) {
     // inits DB file and file pointer
     IDiskStorage::init();
 
-    this->size = size;
-
-    // fill file with zero bits
-    this->benchmark->startProfile("init");
-    for (bigint i = 0; i < this->size; i++) {
-        int itemsWritten = std::fwrite(NULL_ENTRY, ENTRY_LEN, 1, this->file);
-        if (itemsWritten != 1) {
-            std::cerr << "Error: EncIndBase::init(): error initializing file " << this->filename
-                      << " with zero bits (nothing written)" << std::endl;
-            std::exit(EXIT_FAILURE);
-        }
-    }
-    std::fflush(this->file);
-    this->benchmark->stopProfile("init");
+    this->initContents(size);
 }
 
 
-void EncIndBase::clear() {
+template <class Layout>
+void EncIndBase<Layout>::clear() {
     this->size = 0;
+    this->occupancyBitmap.clear();
 
     // clears DB file and file pointer
     IDiskStorage::clear();
 }
 
 
-bool EncIndBase::read(ubigint pos, EncIndVal& ret) const {
+template <class Layout>
+void EncIndBase<Layout>::save(const std::string& filename) {
+    EncIndHeader header {};
+    std::memcpy(header.magic, utils::enc_ind::FILE_MAGIC, sizeof(header.magic));
+    header.formatVersion = utils::enc_ind::FILE_FORMAT_VERSION;
+    header.type = this->getType();
+    header.keyLen = KEY_LEN;
+    header.dataLen = DATA_LEN;
+    header.ivLen = utils::crypto::IV_LEN;
+    this->saveToHeader(header);
+    this->writeAt(&header, sizeof(header), 0);
+
+    IDiskStorage::saveAs(filename);
+}
+
+
+template <class Layout>
+void EncIndBase<Layout>::open(const std::string& filename) {
+    // opens DB file and file pointer (and calls `this->clear()`)
+    IDiskStorage::open(filename);
+
+    EncIndHeader header;
+    if (std::filesystem::file_size(filename) < HEADER_LEN) {
+        std::cerr << "Error: EncIndBase::open(): " << filename << " is too short to be a saved "
+                  << "encrypted index" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    this->readAt(&header, sizeof(header), 0);
+
+    if (std::memcmp(header.magic, utils::enc_ind::FILE_MAGIC, sizeof(header.magic)) != 0) {
+        std::cerr << "Error: EncIndBase::open(): " << filename << " is not a saved encrypted "
+                  << "index" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    if (header.formatVersion != utils::enc_ind::FILE_FORMAT_VERSION) {
+        std::cerr << "Error: EncIndBase::open(): " << filename << " has format version "
+                  << header.formatVersion << " (want " << utils::enc_ind::FILE_FORMAT_VERSION
+                  << ")" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    if (header.type != this->getType()) {
+        std::cerr << "Error: EncIndBase::open(): " << filename << " holds a different kind of "
+                  << "encrypted index" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    if (header.keyLen != KEY_LEN || header.dataLen != DATA_LEN
+            || header.ivLen != utils::crypto::IV_LEN) {
+        std::cerr << "Error: EncIndBase::open(): " << filename << " has entries of length "
+                  << header.keyLen + header.dataLen + header.ivLen << " bytes (want "
+                  << ENTRY_LEN << " bytes)" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    this->openFromHeader(header);
+    if ((bigint)std::filesystem::file_size(filename) < this->calcFileLen()) {
+        std::cerr << "Error: EncIndBase::open(): " << filename << " is truncated" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    if constexpr (config::SHOULD_MMAP_OPENED_ENC_INDS) {
+        this->benchmark->startProfile("mmap");
+        IDiskStorage::mapReadOnly(config::SHOULD_POPULATE_MMAPED_ENC_INDS);
+        this->benchmark->stopProfile("mmap");
+    }
+}
+
+
+template <class Layout>
+bool EncIndBase<Layout>::read(ubigint pos, EncIndVal<Layout>& ret) const {
     pos %= this->size;
 
     uchar entry[ENTRY_LEN];
-    this->benchmark->startProfile("fseek");
-    std::fseek(this->file, pos * ENTRY_LEN, SEEK_SET);
-    this->benchmark->stopProfile("fseek");
-    this->readRaw(entry);
+    this->readRaw(pos, entry);
     if (std::memcmp(entry, NULL_ENTRY, ENTRY_LEN) == 0) {
         // if `pos` contains `NULL_ENTRY`
         return false;
     }
 
-    ret.first = ustring(&entry[KEY_LEN], DATA_LEN);
-    ret.second = ustring(&entry[KEY_LEN + DATA_LEN], utils::crypto::IV_LEN);
+    ret = toEncIndVal(entry);
     return true;
 }
 
 
-void EncIndBase::write(ubigint pos, const EncIndEntry& encIndEntry) {
+template <class Layout>
+void EncIndBase<Layout>::write(ubigint pos, const EncIndEntry<Layout>& encIndEntry) {
     pos %= this->size;
 
-    // encode `encIndEntry` into one string
-    this->benchmark->startProfile("encode");
-    ustring key = encIndEntry.first;
-    EncIndVal val = encIndEntry.second;
-    ustring entry = key + val.first + val.second;
-    if (entry.length() != ENTRY_LEN) {
-        std::cerr << "Error: EncIndBase::write(): write of length " << entry.length()
-                  << " bytes is not allowed! (want " << ENTRY_LEN << " bytes)" << std::endl;
-        std::exit(EXIT_FAILURE);
-    }
-    this->benchmark->stopProfile("encode");
-
-    // then go to `pos` and write the encoded `encIndEntry`
-    this->benchmark->startProfile("fseek");
-    std::fseek(this->file, pos * ENTRY_LEN, SEEK_SET);
-    this->benchmark->stopProfile("fseek");
-    this->benchmark->startProfile("fwrite");
-    int itemsWritten = std::fwrite(entry.c_str(), ENTRY_LEN, 1, this->file);
-    if (itemsWritten != 1) {
-        std::cerr << "Error: EncIndBase::write(): error writing to file " << this->filename
-                  << " (nothing written)" << std::endl;
-        std::exit(EXIT_FAILURE);
-    }
-    this->benchmark->stopProfile("fwrite");
-    // flush immediately to mark space as occupied (and so we always have `this->isFlushed = true`)
-    this->benchmark->startProfile("fflush");
-    std::fflush(this->file);
-    this->benchmark->stopProfile("fflush");
+    // (`EncIndEntry`s are already laid out exactly like on disk, so there's nothing to encode,
+    // and this bypasses stdio buffering, so the space is immediately marked as occupied for
+    // readers and we always have `this->isFlushed = true`)
+    this->writeRaw(pos, encIndEntry.data());
 }
 
 
-bool EncIndBase::find(ubigint& pos, const ustring& key, EncIndVal& ret) const {
+template <class Layout>
+bool EncIndBase<Layout>::find(ubigint& pos, const ustring& key, EncIndVal<Layout>& ret) const {
     bool isFound = this->advanceUntilMatch(pos, key.c_str(), KEY_LEN);
     if (!isFound) {
         return false;
@@ -136,8 +204,28 @@ bool EncIndBase::find(ubigint& pos, const ustring& key, EncIndVal& ret) const {
 }
 
 
-void EncIndBase::writeToFirstEmpty(ubigint& pos, const EncIndEntry& encIndEntry) {
-    bool isEmptyAvailable = this->advanceUntilMatch(pos, NULL_ENTRY, ENTRY_LEN);
+template <class Layout>
+std::vector<bool> EncIndBase<Layout>::findBatch(
+    const std::vector<std::pair<ubigint, ustring>>& posesAndKeys,
+    std::vector<EncIndVal<Layout>>& ret, bool shouldStopAtFirstMiss
+) const {
+    std::vector<bool> isFounds(posesAndKeys.size(), false);
+    ret.assign(posesAndKeys.size(), EncIndVal<Layout> {});
+    for (bigint i = 0; i < (bigint)posesAndKeys.size(); i++) {
+        ubigint pos = posesAndKeys[i].first;
+        isFounds[i] = this->find(pos, posesAndKeys[i].second, ret[i]);
+        if (!isFounds[i] && shouldStopAtFirstMiss) {
+            break;
+        }
+    }
+
+    return isFounds;
+}
+
+
+template <class Layout>
+void EncIndBase<Layout>::writeToFirstEmpty(ubigint& pos, const EncIndEntry<Layout>& encIndEntry) {
+    bool isEmptyAvailable = this->advanceUntilUnoccupied(pos);
     // if we've scoured the whole index and still haven't found an available space,
     // throw an error: we are trying to write to a full index
     if (!isEmptyAvailable) {
@@ -155,15 +243,180 @@ void EncIndBase::writeToFirstEmpty(ubigint& pos, const EncIndEntry& encIndEntry)
 // helpers
 
 
-void EncIndBase::readRaw(uchar* buf) const {
-    this->benchmark->startProfile("fread");
-    bigint itemsRead = std::fread(buf, ENTRY_LEN, 1, this->file);
-    this->benchmark->stopProfile("fread");
-    if (itemsRead != 1) {
-        std::cerr << "Error: EncIndBase::readRaw(): error reading from file " << this->filename
-                  << " (nothing read)" << std::endl;
+template <class Layout>
+void EncIndBase<Layout>::saveToHeader(EncIndHeader& header) {
+    header.size = this->size;
+    header.isTombstoneFree = this->isTombstoneFree;
+}
+
+
+template <class Layout>
+void EncIndBase<Layout>::openFromHeader(const EncIndHeader& header) {
+    this->size = header.size;
+    this->isTombstoneFree = header.isTombstoneFree;
+}
+
+
+template <class Layout>
+void EncIndBase<Layout>::initContents(bigint size) {
+    this->size = size;
+    this->isTombstoneFree = true;
+
+    // mark everything as empty, except the padding bits at the end of the last word
+    bigint unitCount = this->size / this->occupancyUnitLen;
+    this->occupancyBitmap.assign((unitCount + 63) / 64, 0);
+    if (unitCount % 64 != 0) {
+        this->occupancyBitmap.back() = ~(ubigint)0 << (unitCount % 64);
+    }
+
+    // extend the (empty) file to its full length, which the filesystem fills with zero bits
+    // (including any padding) without writing anything: the file is sparse, so this takes the
+    // same time for any size, and only the blocks we actually write to later take up disk space
+    this->benchmark->startProfile("init");
+    if (::ftruncate(::fileno(this->file), this->calcFileLen()) != 0) {
+        std::cerr << "Error: EncIndBase::init(): error extending file " << this->filename
+                  << " to " << this->calcFileLen() << " bytes (" << std::strerror(errno) << ")"
+                  << std::endl;
         std::exit(EXIT_FAILURE);
     }
+    this->benchmark->stopProfile("init");
+}
+
+
+template <class Layout>
+bool EncIndBase<Layout>::advanceUntilUnoccupied(ubigint& pos) const {
+    pos %= this->size;
+
+    bigint wordCount = this->occupancyBitmap.size();
+    ubigint unit = pos / this->occupancyUnitLen;
+    bigint startWordIndex = unit / 64;
+    ubigint startBit = unit % 64;
+    // go through one extra word at the end, since after wrapping around we still have to check
+    // the bits before `unit` in the starting word
+    for (bigint i = 0; i <= wordCount; i++) {
+        bigint wordIndex = (startWordIndex + i) % wordCount;
+        ubigint unoccupiedBits = ~this->occupancyBitmap[wordIndex];
+        if (i == 0) {
+            unoccupiedBits &= ~(ubigint)0 << startBit;
+        } else if (i == wordCount) {
+            unoccupiedBits &= ((ubigint)1 << startBit) - 1;
+        }
+
+        if (unoccupiedBits != 0) {
+            unit = wordIndex * 64 + std::countr_zero(unoccupiedBits);
+            pos = unit * this->occupancyUnitLen;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+template <class Layout>
+EncIndVal<Layout> EncIndBase<Layout>::toEncIndVal(const uchar* entry) {
+    EncIndVal<Layout> encIndVal;
+    std::memcpy(&encIndVal, &entry[KEY_LEN], VAL_LEN);
+    return encIndVal;
+}
+
+
+template <class Layout>
+EncIndValView EncIndBase<Layout>::toEncIndValView(const uchar* entry) {
+    return EncIndValView {
+        std::span<const uchar>(&entry[KEY_LEN], DATA_LEN),
+        std::span<const uchar>(&entry[KEY_LEN + DATA_LEN], utils::crypto::IV_LEN)
+    };
+}
+
+
+template <class Layout>
+bigint EncIndBase<Layout>::findMatchingEntry(
+    const uchar* entries, bigint entryCount, const uchar* match, int matchLen
+) {
+#ifdef __AVX2__
+    if (matchLen >= (int)sizeof(__m256i)) {
+        const __m256i matchPrefix = _mm256_loadu_si256((const __m256i*)match);
+        for (bigint i = 0; i < entryCount; i++) {
+            const uchar* currEntry = entries + (i * ENTRY_LEN);
+            __m256i prefixEq = _mm256_cmpeq_epi8(
+                _mm256_loadu_si256((const __m256i*)currEntry), matchPrefix
+            );
+            if (_mm256_movemask_epi8(prefixEq) == -1 && std::memcmp(
+                currEntry + sizeof(__m256i), match + sizeof(__m256i), matchLen - sizeof(__m256i)
+            ) == 0) {
+                return i;
+            }
+        }
+        return entryCount;
+    }
+#endif
+
+    if (matchLen >= (int)sizeof(ubigint)) {
+        // (`memcpy()` as entries aren't necessarily aligned)
+        ubigint matchPrefix;
+        std::memcpy(&matchPrefix, match, sizeof(ubigint));
+        for (bigint i = 0; i < entryCount; i++) {
+            const uchar* currEntry = entries + (i * ENTRY_LEN);
+            ubigint currPrefix;
+            std::memcpy(&currPrefix, currEntry, sizeof(ubigint));
+            if (currPrefix == matchPrefix && std::memcmp(
+                currEntry + sizeof(ubigint), match + sizeof(ubigint), matchLen - sizeof(ubigint)
+            ) == 0) {
+                return i;
+            }
+        }
+        return entryCount;
+    }
+
+    for (bigint i = 0; i < entryCount; i++) {
+        if (std::memcmp(entries + (i * ENTRY_LEN), match, matchLen) == 0) {
+            return i;
+        }
+    }
+    return entryCount;
+}
+
+
+template <class Layout>
+void EncIndBase<Layout>::readRaw(ubigint pos, uchar* buf, bigint entryCount) const {
+    this->benchmark->startProfile("pread");
+    this->readAt(buf, entryCount * ENTRY_LEN, this->calcFileOffset(pos));
+    this->benchmark->stopProfile("pread");
+}
+
+
+template <class Layout>
+void EncIndBase<Layout>::readRawBatch(
+    const std::vector<ubigint>& positions, uchar* buf, const std::vector<bigint>& entryCounts
+) const {
+    std::vector<utils::async_io::IoReq> reqs;
+    reqs.reserve(positions.size());
+    for (bigint i = 0; i < (bigint)positions.size(); i++) {
+        bigint entryCount = entryCounts.empty() ? 1 : entryCounts[i];
+        reqs.push_back(utils::async_io::IoReq {
+            .buf = buf, .len = entryCount * ENTRY_LEN,
+            .offset = this->calcFileOffset(positions[i])
+        });
+        buf += entryCount * ENTRY_LEN;
+    }
+
+    this->benchmark->startProfile("pread batch");
+    this->readAtBatch(reqs);
+    this->benchmark->stopProfile("pread batch");
+}
+
+
+template <class Layout>
+void EncIndBase<Layout>::writeRaw(ubigint pos, const uchar* buf, bigint entryCount) {
+    this->benchmark->startProfile("pwrite");
+    this->writeAt(buf, entryCount * ENTRY_LEN, this->calcFileOffset(pos));
+    this->benchmark->stopProfile("pwrite");
+
+    for (ubigint unit = pos / this->occupancyUnitLen;
+            unit <= (pos + entryCount - 1) / this->occupancyUnitLen; unit++) {
+        this->occupancyBitmap[unit / 64] |= (ubigint)1 << (unit % 64);
+    }
 }
 
 
@@ -171,27 +424,30 @@ void EncIndBase::readRaw(uchar* buf) const {
 // debugging
 
 
-EncIndEntry EncIndBase::getEncIndEntry(ubigint pos) const {
+template <class Layout>
+EncIndEntry<Layout> EncIndBase<Layout>::getEncIndEntry(ubigint pos) const {
     pos %= this->size;
 
-    uchar entry[ENTRY_LEN];
-    this->benchmark->startProfile("fseek");
-    std::fseek(this->file, pos * ENTRY_LEN, SEEK_SET);
-    this->benchmark->stopProfile("fseek");
-    this->readRaw(entry);
-
-    ustring key = ustring(&entry[0], KEY_LEN);
-    ustring data = ustring(&entry[KEY_LEN], DATA_LEN);
-    ustring iv = ustring(&entry[KEY_LEN + DATA_LEN], utils::crypto::IV_LEN);
-    return EncIndEntry {key, EncIndVal {data, iv}};
+    EncIndEntry<Layout> entry;
+    this->readRaw(pos, entry.data());
+    return entry;
 };
 
 
-void EncIndBase::print() const {
+template <class Layout>
+void EncIndBase<Layout>::print() const {
     for (bigint pos = 0; pos < this->size; pos++) {
-        EncIndEntry entry = this->getEncIndEntry(pos);
+        EncIndEntry<Layout> entry = this->getEncIndEntry(pos);
         std::cerr << pos << ": " << utils::debugging::ustrToHex(utils::enc_ind::toUstr(entry))
                   << std::endl << std::endl;
     }
 }
 
+
+//------------------------------------------------------------------------------
+// explicit template instantiations
+
+
+template class EncIndBase<DbTupleEncIndLayout<Tuple<>>>;
+template class EncIndBase<DbTupleEncIndLayout<SrcIDb1Tuple>>;
+template class EncIndBase<CountEncIndLayout>;
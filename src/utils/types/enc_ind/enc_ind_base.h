@@ -1,8 +1,9 @@
 #pragma once
 
-#include <cmath>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "config.h"
 
@@ -17,21 +18,20 @@
 struct Benchmark;
 
 
+/**
+ * base class of encrypted indexes, whose entries all have the format given by `Layout` (see
+ * `EncIndLayout`).
+ */
+template <class Layout>
 class EncIndBase : public IDiskStorage {
 public:
-    // (both PRF (default) and hash (res-hiding) have 512 bit output)
-    inline static constexpr int KEY_LEN   = utils::crypto::HASH_OUTPUT_LEN;
-    // (currently, encoding a `Tuple<>` is of the form `id,kw[op]dbKw-dbKw`, and encrypting an
-    // exactly n block length plaintext with AES should produce the exact same block ciphertext,
-    // so all but 3 bytes are divided up between `id`, `kw`, and 2 `dbKw`s. however, we actually
-    // must restrict our plaintexts by one more byte or else AES' PCKS #7 padding will generate
-    // an extra block if our plaintext is exactly an integer number of blocks long, thus the `+8`.
-    // we also round up to the next AES block. and also, `SrcIDb1Tuple`s have the same max length.)
-    inline static const int     DATA_LEN  =
-        std::ceil((4 * config::MAX_VALUE_DIGITS + 3) / (float)utils::crypto::BLOCK_SIZE)
-        * utils::crypto::BLOCK_SIZE;
-    inline static constexpr int VAL_LEN   = DATA_LEN + utils::crypto::IV_LEN;
-    inline static constexpr int ENTRY_LEN = KEY_LEN + VAL_LEN;
+    inline static constexpr int KEY_LEN   = Layout::KEY_LEN;
+    inline static constexpr int DATA_LEN  = Layout::DATA_LEN;
+    inline static constexpr int VAL_LEN   = Layout::VAL_LEN;
+    inline static constexpr int ENTRY_LEN = Layout::ENTRY_LEN;
+    // (the header gets a whole page to itself so that entries can still be page-aligned)
+    inline static constexpr bigint HEADER_LEN = utils::enc_ind::PAGE_LEN;
+    static_assert(sizeof(EncIndHeader) <= HEADER_LEN);
 
     //--------------------------------------------------------------------------
     // constructors/destructors
@@ -42,7 +42,7 @@ public:
     // the big five
 
     // destructor
-    ~EncIndBase() = default;
+    ~EncIndBase();
 
     // copy constructor
     EncIndBase(const EncIndBase& other);
@@ -69,13 +69,13 @@ public:
      *     - `true` if the entry at `pos` is valid.
      *     - `false` if the entry at `pos` is the null entry.
      */
-    bool read(ubigint pos, EncIndVal& ret) const;
+    bool read(ubigint pos, EncIndVal<Layout>& ret) const;
 
     /**
      * write to `pos` (but does not check if there is already something there, e.g. from
      * `pos % this->size`, and will overwrite it!).
      */
-    void write(ubigint pos, const EncIndEntry& encIndEntry);
+    void write(ubigint pos, const EncIndEntry<Layout>& encIndEntry);
 
     /**
      * tries to find `key` starting at `pos`, iterating forward from `pos` if the key
@@ -84,41 +84,127 @@ public:
      * returns in `pos`: the location at which `key` was found (in case you may need it for e.g.
      * contiguous reading of a locality-aware bucket after determining its start position).
      *
+     * if `this->isTombstoneFree`, this stops at the first empty location (for pseudorandom
+     * indexes) or empty bucket (for locality-aware indexes) instead, like in any open addressing
+     * hash table, since nothing could have been placed after it.
+     *
      * returns:
      *     - `true` if the entry corresponding to `key` was found.
-     *     - `false` if the entry corresponding to `key` was not found in the entire index.
+     *     - `false` if the entry corresponding to `key` was not found.
+     */
+    bool find(ubigint& pos, const ustring& key, EncIndVal<Layout>& ret) const;
+
+    /**
+     * batched version of `find()` for looking up many keys at once (e.g. consecutive labels of
+     * one keyword), so that implementations can have all of the reads needed in flight together.
+     * this default version just calls `find()` for each key one by one.
+     *
+     * if `shouldStopAtFirstMiss`, nothing after the first key that isn't found can be found either
+     * (e.g. consecutive labels of one keyword), so lookups stop there and every key after it is
+     * reported as not found.
+     *
+     * returns: whether each of `posesAndKeys` was found; if so, its value is in the
+     * corresponding entry of `ret`.
      */
-    bool find(ubigint& pos, const ustring& key, EncIndVal& ret) const;
+    std::vector<bool> findBatch(
+        const std::vector<std::pair<ubigint, ustring>>& posesAndKeys,
+        std::vector<EncIndVal<Layout>>& ret, bool shouldStopAtFirstMiss = false
+    ) const;
 
     /**
      * write to first *empty* location at or after `pos`, iterating forward from `pos` until
-     * an empty location is found.
+     * an empty location is found (this only consults the occupancy bitmap, so there is no I/O
+     * until the actual write).
      *
      * returns in `pos`: this final empty location (in case you may need it for e.g.
      * contiguous writing of a locality-aware bucket after determining its start position).
      */
-    void writeToFirstEmpty(ubigint& pos, const EncIndEntry& encIndEntry);
+    void writeToFirstEmpty(ubigint& pos, const EncIndEntry<Layout>& encIndEntry);
+
+    /**
+     * write this index's header (see `EncIndHeader`) and move its file to `filename`, where it
+     * stays after this object is gone, so it can be reopened later with `open()` instead of
+     * being rebuilt.
+     */
+    void save(const std::string& filename);
+
+    /**
+     * replace this index with the one saved at `filename` by `save()`, exiting if it isn't the
+     * same kind of index or doesn't have the same format as this build. opened indexes can be
+     * searched but not written to (the file is read-only, and e.g. the occupancy bitmap, which is
+     * only needed during setup, isn't kept), and are served from a read-only mapping of the file
+     * if `config::SHOULD_MMAP_OPENED_ENC_INDS`.
+     */
+    void open(const std::string& filename);
 
     bigint getSize() const { return this->size; }
+    // (bytes of entries, including any bucket alignment padding, but not the file header, so that
+    // storage is counted the same way as `getSize() * ENTRY_LEN` for unpadded indexes)
+    bigint getStorageLen() const { return this->calcFileLen() - HEADER_LEN; }
+    bool getIsTombstoneFree() const { return this->isTombstoneFree; }
 
     //--------------------------------------------------------------------------
     // debugging
 
-    EncIndEntry getEncIndEntry(ubigint pos) const;
+    EncIndEntry<Layout> getEncIndEntry(ubigint pos) const;
     void print() const; // (warning: this can be, like, a LOT of stuff!! :3)
 
 protected:
     constexpr std::string FILE_DIR() const override { return "out/server"; }
     constexpr std::string FILENAME_PREFIX() const override { return "enc_ind_"; }
+    constexpr bigint FILE_POOL_CAPACITY() const override {
+        return config::ENC_IND_FILE_POOL_CAPACITY;
+    }
 
     static const uchar NULL_ENTRY[ENTRY_LEN];
 
     bigint size = 0;
     std::shared_ptr<Benchmark> benchmark;
 
+    // format flag for whether entries have only ever been written into empty locations and never
+    // removed (true for everything built by `init()` + writes), which is what allows lookups to
+    // stop at the first empty location
+    bool isTombstoneFree = true;
+
+    // client-side occupancy bitmap kept up to date by writes during setup, with one bit per
+    // `occupancyUnitLen` entries (e.g. one bit per bucket for locality-aware indexes);
+    // unused trailing bits are set so they never look empty
+    std::vector<ubigint> occupancyBitmap;
+    bigint occupancyUnitLen = 1;
+
     //--------------------------------------------------------------------------
     // helpers
 
+    /**
+     * the part of `init()` after the file is created: set up the in-memory state for `size`
+     * entries and fill the file with null entries. (children that need to set up their file
+     * layout first can call `IDiskStorage::init()`, then their setup, then this, since
+     * `IDiskStorage::init()` calls `clear()`.)
+     */
+    void initContents(bigint size);
+
+    virtual EncIndType getType() const = 0;
+
+    /**
+     * fill in this index's parameters in `header` when saving (plus write anything else it
+     * needs to keep after the entries), or restore them from `header` when opening. children
+     * with extra parameters should extend these.
+     */
+    virtual void saveToHeader(EncIndHeader& header);
+    virtual void openFromHeader(const EncIndHeader& header);
+
+    /**
+     * returns: byte offset in the index file of the entry at `pos` (entries are packed
+     * back to back after the header by default, but children may pad them out, e.g. for
+     * aligned I/O).
+     */
+    virtual bigint calcFileOffset(ubigint pos) const { return HEADER_LEN + pos * ENTRY_LEN; }
+
+    /**
+     * returns: total length in bytes of the index file (header and entries).
+     */
+    virtual bigint calcFileLen() const { return HEADER_LEN + this->size * ENTRY_LEN; }
+
     /**
      * advance forward from `pos` until the first `matchLen` bytes of the current entry
      * matches `match`, or we've traversed the entire index.
@@ -131,5 +217,56 @@ protected:
      */
     virtual bool advanceUntilMatch(ubigint& pos, const uchar* match, int matchLen) const = 0;
 
-    void readRaw(uchar* buf) const;
+    /**
+     * advance forward from `pos` (wrapping around) to the start of the first unoccupied unit
+     * according to `this->occupancyBitmap`, scanning a word of bits at a time.
+     *
+     * returned in `pos`: the start of the first unoccupied unit (if we found one).
+     *
+     * returns:
+     *     - `true` if an unoccupied unit was found.
+     *     - `false` if the entire index is occupied.
+     */
+    bool advanceUntilUnoccupied(ubigint& pos) const;
+
+    /**
+     * decode the value part of the raw entry `entry` (either by copying it out, or as a view).
+     */
+    static EncIndVal<Layout> toEncIndVal(const uchar* entry);
+    static EncIndValView toEncIndValView(const uchar* entry);
+
+    /**
+     * scan `entryCount` contiguous raw entries at `entries` (e.g. a read buffer, or a mapped
+     * region of the index file) for the first one whose first `matchLen` bytes match `match`.
+     * each entry is first filtered on a prefix of its key (32 bytes at once with AVX2, otherwise
+     * 8 bytes) and only then fully compared.
+     *
+     * returns: the index of the first matching entry, or `entryCount` if none match.
+     */
+    static bigint findMatchingEntry(
+        const uchar* entries, bigint entryCount, const uchar* match, int matchLen
+    );
+
+    /**
+     * read `entryCount` raw, contiguous entries starting at `pos` (which must not wrap around,
+     * or cross any padding from `calcFileOffset()`) into `buf` with a single positional read,
+     * so this is safe for concurrent searchers.
+     */
+    void readRaw(ubigint pos, uchar* buf, bigint entryCount = 1) const;
+
+    /**
+     * read `entryCounts[i]` (or one, if `entryCounts` is empty) raw, contiguous entries starting
+     * at each of `positions` (same restrictions as `readRaw()`) one after another into `buf`,
+     * with all of the reads in flight at once.
+     */
+    void readRawBatch(
+        const std::vector<ubigint>& positions, uchar* buf,
+        const std::vector<bigint>& entryCounts = {}
+    ) const;
+
+    /**
+     * write `entryCount` raw, contiguous entries from `buf` starting at `pos` (which must not wrap
+     * around) with a single positional write.
+     */
+    virtual void writeRaw(ubigint pos, const uchar* buf, bigint entryCount = 1);
 };
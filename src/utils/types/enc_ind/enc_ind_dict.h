@@ -0,0 +1,16 @@
+#pragma once
+
+#include <type_traits>
+
+#include "config.h"
+
+#include "utils/types/enc_ind/enc_ind_rand.h"
+#include "utils/types/enc_ind/enc_ind_robin_hood.h"
+
+
+// the pseudorandom (i.e. non-locality) encrypted index used as a dictionary by PiBas and NLogN
+// make sure that `EncIndDict` is always a type that inherits from `EncIndBase`!
+template <class Layout>
+using EncIndDict = std::conditional<
+    config::USE_ROBIN_HOOD_ENC_INDS, EncIndRobinHood<Layout>, EncIndRand<Layout>
+>::type;
@@ -1,30 +1,268 @@
 #include "utils/types/enc_ind/enc_ind_loc.h"
 
-#include <cstdio>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "config.h"
 
 #include "utils/benchmark.h"
-#include "utils/types/enc_ind/enc_ind_base.h"
 #include "utils/types/basic_types.h"
+#include "utils/types/enc_ind/enc_ind_base.h"
+#include "utils/types/enc_ind/enc_ind_utils.h"
+#include "utils/types/tuple.h"
+
+
+//------------------------------------------------------------------------------
+// the big five
+
+
+// destructor
+template <class Layout>
+EncIndLoc<Layout>::~EncIndLoc() {
+    this->closeDirectFd();
+}
+
+
+// copy constructor
+template <class Layout>
+EncIndLoc<Layout>::EncIndLoc(const EncIndLoc& other) : EncIndBase<Layout>(other) {
+    this->bcktSize = other.bcktSize;
+    this->bcktCount = other.bcktCount;
+    this->isBcktAligned = other.isBcktAligned;
+    this->bcktStrideLen = other.bcktStrideLen;
+    // (`other`'s descriptor is for `other`'s file, not our copy of it)
+    if (other.directFd >= 0) {
+        this->openDirectFd();
+    }
+}
+
+
+// copy assignment operator
+template <class Layout>
+EncIndLoc<Layout>& EncIndLoc<Layout>::operator =(const EncIndLoc& other) {
+    if (this != &other) {
+        this->closeDirectFd();
+        EncIndBase<Layout>::operator =(other);
+        this->bcktSize = other.bcktSize;
+        this->bcktCount = other.bcktCount;
+        this->isBcktAligned = other.isBcktAligned;
+        this->bcktStrideLen = other.bcktStrideLen;
+        if (other.directFd >= 0) {
+            this->openDirectFd();
+        }
+    }
+    return *this;
+}
+
+
+// move constructor
+template <class Layout>
+EncIndLoc<Layout>::EncIndLoc(EncIndLoc&& other) noexcept : EncIndBase<Layout>(std::move(other)) {
+    this->bcktSize = other.bcktSize;
+    this->bcktCount = other.bcktCount;
+    this->isBcktAligned = other.isBcktAligned;
+    this->bcktStrideLen = other.bcktStrideLen;
+    this->directFd = other.directFd;
+    other.directFd = -1;
+}
+
+
+// move assignment operator
+template <class Layout>
+EncIndLoc<Layout>& EncIndLoc<Layout>::operator =(EncIndLoc&& other) noexcept {
+    if (this != &other) {
+        this->closeDirectFd();
+        EncIndBase<Layout>::operator =(std::move(other));
+        this->bcktSize = other.bcktSize;
+        this->bcktCount = other.bcktCount;
+        this->isBcktAligned = other.isBcktAligned;
+        this->bcktStrideLen = other.bcktStrideLen;
+        this->directFd = other.directFd;
+        other.directFd = -1;
+    }
+    return *this;
+}
 
 
 //------------------------------------------------------------------------------
 // interface
 
 
-void EncIndLoc::init(bigint bcktSize, bigint bcktCount) {
-    EncIndBase::init(bcktSize * bcktCount);
+template <class Layout>
+void EncIndLoc<Layout>::init(bigint bcktSize, bigint bcktCount) {
+    // inits DB file and file pointer (and calls `this->clear()`)
+    IDiskStorage::init();
 
+    // (the layout must be set before `EncIndBase::initContents()`, which uses it)
     this->bcktSize = bcktSize;
     this->bcktCount = bcktCount;
+    bigint unpaddedBcktLen = bcktSize * ENTRY_LEN;
+    this->isBcktAligned =
+        config::SHOULD_USE_DIRECT_IO_FOR_ENC_IND_LOCS && unpaddedBcktLen >= PAGE_LEN;
+    if (this->isBcktAligned) {
+        this->bcktStrideLen = (unpaddedBcktLen + PAGE_LEN - 1) / PAGE_LEN * PAGE_LEN;
+    } else {
+        this->bcktStrideLen = unpaddedBcktLen;
+    }
+    // (each bucket only ever holds one keyword, so we only need to track occupancy per bucket)
+    this->occupancyUnitLen = bcktSize;
+
+    this->initContents(bcktSize * bcktCount);
+
+    if (this->isBcktAligned) {
+        this->openDirectFd();
+    }
 }
 
 
-void EncIndLoc::clear() {
-    EncIndBase::clear();
+template <class Layout>
+void EncIndLoc<Layout>::clear() {
+    this->closeDirectFd();
+
+    EncIndBase<Layout>::clear();
 
     this->bcktSize = 0;
     this->bcktCount = 0;
+    this->isBcktAligned = false;
+    this->bcktStrideLen = 0;
+    this->occupancyUnitLen = 1;
+}
+
+
+template <class Layout>
+bool EncIndLoc<Layout>::findBckt(
+    ubigint pos, const ustring& key, bigint entryCount, EncIndBuf& retBuf,
+    std::vector<EncIndValView>& ret
+) const {
+    pos %= this->size;
+    entryCount = std::min(entryCount, this->bcktSize);
+    ret.clear();
+
+    this->readBcktRaw(pos, entryCount, retBuf);
+    if (std::memcmp(retBuf.data(), key.c_str(), KEY_LEN) != 0) {
+        // bucket isn't at its home position, so find where it is first (starting from the next
+        // bucket, since we've already checked this one)
+        if (!this->hasBcktMovedFrom(retBuf.data())) {
+            return false;
+        }
+        pos = (pos + this->bcktSize) % this->size;
+        bool isFound = this->advanceUntilMatch(pos, key.c_str(), KEY_LEN);
+        if (!isFound) {
+            return false;
+        }
+        this->readBcktRaw(pos, entryCount, retBuf);
+    }
+
+    ret.reserve(entryCount);
+    for (bigint i = 0; i < entryCount; i++) {
+        const uchar* currEntry = retBuf.data() + (i * ENTRY_LEN);
+        if (std::memcmp(currEntry, NULL_ENTRY, ENTRY_LEN) == 0) {
+            break;
+        }
+        ret.push_back(this->toEncIndValView(currEntry));
+    }
+
+    return true;
+}
+
+
+template <class Layout>
+std::vector<bool> EncIndLoc<Layout>::findBcktBatch(
+    const std::vector<BcktReq>& bckts, std::vector<EncIndBuf>& retBufs,
+    std::vector<std::vector<EncIndValView>>& ret
+) const {
+    bigint bcktCount = bckts.size();
+    std::vector<bool> isFounds(bcktCount, false);
+    ret.assign(bcktCount, std::vector<EncIndValView> {});
+
+    std::vector<ubigint> poses(bcktCount);
+    std::vector<bigint> entryCounts(bcktCount);
+    std::vector<bigint> order(bcktCount);
+    for (bigint i = 0; i < bcktCount; i++) {
+        poses[i] = bckts[i].pos % this->size;
+        entryCounts[i] = std::min(bckts[i].entryCount, this->bcktSize);
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](bigint i1, bigint i2) {
+        return poses[i1] < poses[i2];
+    });
+
+    // where each bucket's entries ended up: which of `retBufs`, and at which entry within it
+    std::vector<std::pair<bigint, bigint>> bcktLocs(bcktCount);
+    // buckets that weren't at their home positions
+    std::vector<bigint> movedInds;
+
+    // read runs of overlapping/adjacent buckets with one read each (buckets never wrap around,
+    // so neither do runs)
+    bigint runStartInd = 0;
+    while (runStartInd < bcktCount) {
+        ubigint runStartPos = poses[order[runStartInd]];
+        ubigint runEndPos = runStartPos + entryCounts[order[runStartInd]];
+        bigint runEndInd = runStartInd + 1;
+        while (runEndInd < bcktCount) {
+            ubigint pos = poses[order[runEndInd]];
+            bool canJoinRun = this->isBcktAligned ? pos == runStartPos : pos <= runEndPos;
+            if (!canJoinRun) {
+                break;
+            }
+            runEndPos = std::max(runEndPos, pos + entryCounts[order[runEndInd]]);
+            runEndInd++;
+        }
+
+        EncIndBuf& runBuf = retBufs.emplace_back();
+        this->readBcktRaw(runStartPos, runEndPos - runStartPos, runBuf);
+        for (bigint i = runStartInd; i < runEndInd; i++) {
+            bigint bcktInd = order[i];
+            bigint offset = poses[bcktInd] - runStartPos;
+            const uchar* bcktStart = runBuf.data() + offset * ENTRY_LEN;
+            if (std::memcmp(bcktStart, bckts[bcktInd].key.c_str(), KEY_LEN) == 0) {
+                bcktLocs[bcktInd] = std::pair {(bigint)retBufs.size() - 1, offset};
+                isFounds[bcktInd] = true;
+            } else if (this->hasBcktMovedFrom(bcktStart)) {
+                movedInds.push_back(bcktInd);
+            }
+        }
+        runStartInd = runEndInd;
+    }
+
+    // find buckets that were moved by collisions the same way as `findBckt()`
+    for (bigint bcktInd : movedInds) {
+        ubigint pos = (poses[bcktInd] + this->bcktSize) % this->size;
+        if (!this->advanceUntilMatch(pos, bckts[bcktInd].key.c_str(), KEY_LEN)) {
+            continue;
+        }
+        this->readBcktRaw(pos, entryCounts[bcktInd], retBufs.emplace_back());
+        bcktLocs[bcktInd] = std::pair {(bigint)retBufs.size() - 1, 0};
+        isFounds[bcktInd] = true;
+    }
+
+    // (only take views once all the reads are done, since adding buffers may move the others,
+    // though not their contents)
+    for (bigint bcktInd = 0; bcktInd < bcktCount; bcktInd++) {
+        if (!isFounds[bcktInd]) {
+            continue;
+        }
+        const uchar* bcktStart =
+            retBufs[bcktLocs[bcktInd].first].data() + bcktLocs[bcktInd].second * ENTRY_LEN;
+        ret[bcktInd].reserve(entryCounts[bcktInd]);
+        for (bigint i = 0; i < entryCounts[bcktInd]; i++) {
+            const uchar* currEntry = bcktStart + (i * ENTRY_LEN);
+            if (std::memcmp(currEntry, NULL_ENTRY, ENTRY_LEN) == 0) {
+                break;
+            }
+            ret[bcktInd].push_back(this->toEncIndValView(currEntry));
+        }
+    }
+
+    return isFounds;
 }
 
 
@@ -32,7 +270,38 @@ void EncIndLoc::clear() {
 // helpers
 
 
-bool EncIndLoc::advanceUntilMatch(ubigint& pos, const uchar* match, int matchLen) const {
+template <class Layout>
+void EncIndLoc<Layout>::saveToHeader(EncIndHeader& header) {
+    EncIndBase<Layout>::saveToHeader(header);
+
+    header.bcktSize = this->bcktSize;
+    header.bcktCount = this->bcktCount;
+    header.isBcktAligned = this->isBcktAligned;
+    header.bcktStrideLen = this->bcktStrideLen;
+}
+
+
+template <class Layout>
+void EncIndLoc<Layout>::openFromHeader(const EncIndHeader& header) {
+    EncIndBase<Layout>::openFromHeader(header);
+
+    // (we keep whatever layout the file was saved with, even if our config would now pick a
+    // different one)
+    this->bcktSize = header.bcktSize;
+    this->bcktCount = header.bcktCount;
+    this->isBcktAligned = header.isBcktAligned;
+    this->bcktStrideLen = header.bcktStrideLen;
+    this->occupancyUnitLen = this->bcktSize;
+
+    // (`O_DIRECT` would bypass the page cache that the mapping is supposed to share)
+    if (this->isBcktAligned && !config::SHOULD_MMAP_OPENED_ENC_INDS) {
+        this->openDirectFd();
+    }
+}
+
+
+template <class Layout>
+bool EncIndLoc<Layout>::advanceUntilMatch(ubigint& pos, const uchar* match, int matchLen) const {
     pos %= this->size;
 
     // get entry at `pos`, and if it doesn't match `match` (e.g. because of `pos %= this->size`),
@@ -41,31 +310,116 @@ bool EncIndLoc::advanceUntilMatch(ubigint& pos, const uchar* match, int matchLen
     // importantly, we get the massive optimization of only having to check the first entry of every
     // bucket/every `this->bcktSize` entries, as locality guarantees contiguousness of buckets
     uchar currEntry[ENTRY_LEN];
-    this->benchmark->startProfile("fseek");
-    std::fseek(this->file, pos * ENTRY_LEN, SEEK_SET);
-    this->benchmark->stopProfile("fseek");
-    this->readRaw(currEntry);
+    this->readRaw(pos, currEntry);
     bigint positionsChecked = 0;
     while (std::memcmp(currEntry, match, matchLen) != 0) {
+        // buckets are placed at the first empty bucket at or after their home bucket, so key
+        // lookups can give up once they reach an empty bucket
+        if (this->isTombstoneFree && matchLen == KEY_LEN
+                && std::memcmp(currEntry, NULL_ENTRY, ENTRY_LEN) == 0) {
+            return false;
+        }
+
         positionsChecked++;
         if (positionsChecked == this->bcktCount) {
             return false;
         }
 
         pos = (pos + this->bcktSize) % this->size;
-        // if either we need to `fseek()` to further than we had `fread()` (i.e.
-        // `this->bcktSize` > 1), or `pos` had been decreased this iteration (i.e.
-        // `pos < this->bcktSize`) meaning we must've wrapped around, call `fseek()`
-        // to make sure we are on the correct position (otherwise the previous `fread()`
-        // automatically handles it, so we can save some time)
-        if (this->bcktSize > 1 || pos < this->bcktSize) {
-            this->benchmark->startProfile("fseek");
-            std::fseek(this->file, pos * ENTRY_LEN, SEEK_SET);
-            this->benchmark->stopProfile("fseek");
+        this->readRaw(pos, currEntry);
+    }
+    
+    return true;
+}
+
+
+template <class Layout>
+bool EncIndLoc<Layout>::hasBcktMovedFrom(const uchar* homeBcktStart) const {
+    // (same early termination as `advanceUntilMatch()`: an empty home bucket means the bucket
+    // we're looking for was never placed anywhere)
+    if (this->isTombstoneFree && std::memcmp(homeBcktStart, NULL_ENTRY, ENTRY_LEN) == 0) {
+        return false;
+    }
+    return this->bcktCount > 1;
+}
+
+
+template <class Layout>
+bigint EncIndLoc<Layout>::calcFileOffset(ubigint pos) const {
+    return HEADER_LEN + (pos / this->bcktSize) * this->bcktStrideLen
+        + (pos % this->bcktSize) * ENTRY_LEN;
+}
+
+
+template <class Layout>
+bigint EncIndLoc<Layout>::calcFileLen() const {
+    return HEADER_LEN + this->bcktCount * this->bcktStrideLen;
+}
+
+
+template <class Layout>
+void EncIndLoc<Layout>::readBcktRaw(
+    ubigint bcktStartPos, bigint entryCount, EncIndBuf& retBuf
+) const {
+    // read directly from disk if we can (the read length must then also be page-aligned)
+    if (this->directFd >= 0) {
+        bigint alignedLen = (entryCount * ENTRY_LEN + PAGE_LEN - 1) / PAGE_LEN * PAGE_LEN;
+        retBuf.resize(alignedLen);
+        if (this->readDirect(retBuf.data(), alignedLen, this->calcFileOffset(bcktStartPos))) {
+            return;
         }
+    }
+
+    retBuf.resize(entryCount * ENTRY_LEN);
+    this->readRaw(bcktStartPos, retBuf.data(), entryCount);
+}
+
+
+template <class Layout>
+void EncIndLoc<Layout>::openDirectFd() {
+    this->closeDirectFd();
+    // (if this fails, e.g. with `EINVAL` on filesystems like tmpfs, we just keep reading buckets
+    // through the page cache)
+    this->directFd = ::open(this->filename.c_str(), O_RDONLY | O_DIRECT);
+}
+
 
-        this->readRaw(currEntry);
+template <class Layout>
+void EncIndLoc<Layout>::closeDirectFd() {
+    if (this->directFd >= 0) {
+        ::close(this->directFd);
+        this->directFd = -1;
     }
-    
+}
+
+
+template <class Layout>
+bool EncIndLoc<Layout>::readDirect(uchar* buf, bigint len, bigint offset) const {
+    this->benchmark->startProfile("pread direct");
+    bigint bytesRead = 0;
+    while (bytesRead < len) {
+        ssize_t res = ::pread(this->directFd, buf + bytesRead, len - bytesRead, offset + bytesRead);
+        if (res < 0 && errno == EINVAL) {
+            this->benchmark->stopProfile("pread direct");
+            return false;
+        }
+        if (res <= 0) {
+            std::cerr << "Error: EncIndLoc::readDirect(): error reading from file "
+                      << this->filename << " (only read " << bytesRead << " out of " << len
+                      << " bytes)" << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        bytesRead += res;
+    }
+    this->benchmark->stopProfile("pread direct");
+
     return true;
 }
+
+
+//------------------------------------------------------------------------------
+// explicit template instantiations
+
+
+template class EncIndLoc<DbTupleEncIndLayout<Tuple<>>>;
+template class EncIndLoc<DbTupleEncIndLayout<SrcIDb1Tuple>>;
@@ -1,34 +1,48 @@
 #pragma once
 
+#include <vector>
+
 #include "utils/types/basic_types.h"
 #include "utils/types/enc_ind/enc_ind_base.h"
+#include "utils/types/enc_ind/enc_ind_utils.h"
 #include "utils/types/ustring.h"
 
 
-class EncIndLoc : public EncIndBase {
+template <class Layout>
+class EncIndLoc : public EncIndBase<Layout> {
 public:
+    using EncIndBase<Layout>::KEY_LEN;
+    using EncIndBase<Layout>::ENTRY_LEN;
+
+    // one bucket to look up with `findBcktBatch()` (same as the params of `findBckt()`)
+    struct BcktReq {
+        ubigint pos;
+        ustring key;
+        bigint entryCount;
+    };
+
     //--------------------------------------------------------------------------
     // constructors/destructors
 
-    using EncIndBase::EncIndBase;
+    using EncIndBase<Layout>::EncIndBase;
 
     //--------------------------------------------------------------------------
     // the big five
 
     // destructor
-    ~EncIndLoc() = default;
+    ~EncIndLoc();
 
     // copy constructor
-    EncIndLoc(const EncIndLoc& other) = default;
+    EncIndLoc(const EncIndLoc& other);
 
     // copy assignment operator
-    EncIndLoc& operator =(const EncIndLoc& other) = default;
+    EncIndLoc& operator =(const EncIndLoc& other);
 
     // move constructor
-    EncIndLoc(EncIndLoc&& other) noexcept = default;
+    EncIndLoc(EncIndLoc&& other) noexcept;
 
     // move assignment operator
-    EncIndLoc& operator =(EncIndLoc&& other) noexcept = default;
+    EncIndLoc& operator =(EncIndLoc&& other) noexcept;
 
     //--------------------------------------------------------------------------
     // interface
@@ -36,12 +50,86 @@ public:
     void init(bigint bcktSize, bigint bcktCount);
     void clear() override;
 
+    /**
+     * find the bucket starting with `key` at or after `pos` (like `find()`), and read its first
+     * `entryCount` entries with one contiguous read (an `O_DIRECT` read if this level's buckets
+     * are page-aligned) into `retBuf`, which can be reused across calls.
+     *
+     * since we first optimistically read the whole bucket at `pos` itself (where it is unless
+     * it got moved by a collision), this is usually a single I/O.
+     *
+     * returns in `ret`: views into `retBuf` of the bucket's entries up until the first null entry.
+     *
+     * returns:
+     *     - `true` if the bucket for `key` was found.
+     *     - `false` if the bucket for `key` was not found.
+     */
+    bool findBckt(
+        ubigint pos, const ustring& key, bigint entryCount, EncIndBuf& retBuf,
+        std::vector<EncIndValView>& ret
+    ) const;
+
+    /**
+     * batched version of `findBckt()` for looking up many buckets at once: the buckets are read
+     * in order of position, and overlapping or adjacent buckets (e.g. the same bucket wanted by
+     * different queries) are read together with one contiguous read (only identical ones if
+     * buckets are padded out for direct I/O, since one read can't skip the padding).
+     *
+     * returns in `ret`: views of each bucket's entries (like `findBckt()`) into buffers appended
+     * to `retBufs`, which stay valid as long as those buffers do.
+     *
+     * returns: whether each of `bckts` was found.
+     */
+    std::vector<bool> findBcktBatch(
+        const std::vector<BcktReq>& bckts, std::vector<EncIndBuf>& retBufs,
+        std::vector<std::vector<EncIndValView>>& ret
+    ) const;
+
 private:
+    using EncIndBase<Layout>::HEADER_LEN;
+    using EncIndBase<Layout>::NULL_ENTRY;
+
+    inline static constexpr bigint PAGE_LEN = utils::enc_ind::PAGE_LEN;
+
     bigint bcktSize = 0;
     bigint bcktCount = 0;
+    // (if `config::SHOULD_USE_DIRECT_IO_FOR_ENC_IND_LOCS` and buckets are at least a page long,
+    // each bucket is padded to a multiple of `PAGE_LEN` so it can be read directly from disk)
+    bool isBcktAligned = false;
+    bigint bcktStrideLen = 0;
+    // separate `O_DIRECT` descriptor for bucket reads (or `-1` if not aligned, or if the
+    // filesystem doesn't support `O_DIRECT`, in which case we just read through the page cache)
+    int directFd = -1;
 
     //--------------------------------------------------------------------------
     // helpers
 
+    EncIndType getType() const override { return EncIndType::LOC; }
+    void saveToHeader(EncIndHeader& header) override;
+    void openFromHeader(const EncIndHeader& header) override;
+
     bool advanceUntilMatch(ubigint& pos, const uchar* match, int matchLen) const override;
+    /**
+     * whether the bucket looked up at the home bucket starting at `homeBcktStart` (which didn't
+     * match) may have been moved further along by collisions, i.e. is worth probing for.
+     */
+    bool hasBcktMovedFrom(const uchar* homeBcktStart) const;
+    bigint calcFileOffset(ubigint pos) const override;
+    bigint calcFileLen() const override;
+
+    /**
+     * read the first `entryCount` entries of the bucket starting at `bcktStartPos` into `retBuf`
+     * with one contiguous read.
+     */
+    void readBcktRaw(ubigint bcktStartPos, bigint entryCount, EncIndBuf& retBuf) const;
+
+    void openDirectFd();
+    void closeDirectFd();
+
+    /**
+     * read `len` bytes at the page-aligned `offset` through `this->directFd` into `buf`.
+     *
+     * returns: `false` if `O_DIRECT` reads turned out to be unsupported here (e.g. `EINVAL`).
+     */
+    bool readDirect(uchar* buf, bigint len, bigint offset) const;
 };
@@ -1,72 +1,302 @@
 #include "utils/types/enc_ind/enc_ind_rand.h"
 
 #include <algorithm>
-#include <cstdio>
-#include <cstdlib>
 #include <cstring>
-#include <iostream>
+#include <utility>
+#include <vector>
 
 #include "config.h"
 
-#include "utils/benchmark.h"
 #include "utils/types/basic_types.h"
 #include "utils/types/enc_ind/enc_ind_base.h"
+#include "utils/types/enc_ind/enc_ind_utils.h"
+#include "utils/types/tuple.h"
 #include "utils/types/ustring.h"
 
 
+//------------------------------------------------------------------------------
+// interface
+
+
+template <class Layout>
+void EncIndRand<Layout>::init(bigint size) {
+    EncIndBase<Layout>::init(size);
+
+    if constexpr (config::SHOULD_KEEP_ENC_IND_FINGERPRINTS) {
+        this->fingerprints.assign(this->size, 0);
+    }
+}
+
+
+template <class Layout>
+void EncIndRand<Layout>::clear() {
+    EncIndBase<Layout>::clear();
+
+    this->fingerprints.clear();
+}
+
+
+template <class Layout>
+std::vector<bool> EncIndRand<Layout>::findBatch(
+    const std::vector<std::pair<ubigint, ustring>>& posesAndKeys,
+    std::vector<EncIndVal<Layout>>& ret, bool shouldStopAtFirstMiss
+) const {
+    if (!this->canUseFingerprints()) {
+        return this->findBatchByProbing(posesAndKeys, ret, shouldStopAtFirstMiss);
+    }
+
+    // gather every slot that could hold each key (along with which key it's for)
+    std::vector<ubigint> candidatePoses;
+    std::vector<bigint> candidateKeyIndices;
+    for (bigint i = 0; i < (bigint)posesAndKeys.size(); i++) {
+        ubigint pos = posesAndKeys[i].first % this->size;
+        const uchar keyFingerprint = calcFingerprint(posesAndKeys[i].second.c_str());
+        bigint candidateCount = 0;
+        for (bigint positionsChecked = 0; positionsChecked < this->size; positionsChecked++) {
+            uchar currFingerprint = this->fingerprints[pos];
+            if (currFingerprint == 0) {
+                break;
+            }
+            if (currFingerprint == keyFingerprint) {
+                candidatePoses.push_back(pos);
+                candidateKeyIndices.push_back(i);
+                candidateCount++;
+            }
+
+            pos = (pos + 1) % this->size;
+        }
+        // (a key without any candidates is a sure miss, so we don't need to look any further)
+        if (candidateCount == 0 && shouldStopAtFirstMiss) {
+            break;
+        }
+    }
+
+    // then read them all at once and check which ones actually match
+    std::vector<uchar> candidateEntries(candidatePoses.size() * ENTRY_LEN);
+    this->readRawBatch(candidatePoses, candidateEntries.data());
+    std::vector<bool> isFounds(posesAndKeys.size(), false);
+    ret.assign(posesAndKeys.size(), EncIndVal<Layout> {});
+    for (bigint j = 0; j < (bigint)candidatePoses.size(); j++) {
+        bigint i = candidateKeyIndices[j];
+        const uchar* candidateEntry = candidateEntries.data() + (j * ENTRY_LEN);
+        const uchar* key = posesAndKeys[i].second.c_str();
+        if (!isFounds[i] && std::memcmp(candidateEntry, key, KEY_LEN) == 0) {
+            isFounds[i] = true;
+            ret[i] = this->toEncIndVal(candidateEntry);
+        }
+    }
+
+    if (shouldStopAtFirstMiss) {
+        auto firstMissIter = std::find(isFounds.begin(), isFounds.end(), false);
+        std::fill(firstMissIter, isFounds.end(), false);
+    }
+    return isFounds;
+}
+
+
 //------------------------------------------------------------------------------
 // helpers
 
 
-bool EncIndRand::advanceUntilMatch(ubigint& pos, const uchar* match, int matchLen) const {
+template <class Layout>
+void EncIndRand<Layout>::saveToHeader(EncIndHeader& header) {
+    EncIndBase<Layout>::saveToHeader(header);
+
+    if (!this->fingerprints.empty()) {
+        this->writeAt(this->fingerprints.data(), this->fingerprints.size(), this->calcFileLen());
+        header.fingerprintsLen = this->fingerprints.size();
+    }
+}
+
+
+template <class Layout>
+void EncIndRand<Layout>::openFromHeader(const EncIndHeader& header) {
+    EncIndBase<Layout>::openFromHeader(header);
+
+    if constexpr (config::SHOULD_KEEP_ENC_IND_FINGERPRINTS) {
+        // (no point holding on to them if we can't use them)
+        if (header.fingerprintsLen == this->size && this->isTombstoneFree) {
+            this->fingerprints.resize(this->size);
+            this->readAt(this->fingerprints.data(), this->size, this->calcFileLen());
+        }
+    }
+}
+
+
+template <class Layout>
+bool EncIndRand<Layout>::advanceUntilMatch(ubigint& pos, const uchar* match, int matchLen) const {
+    if (matchLen == KEY_LEN && this->canUseFingerprints()) {
+        return this->advanceUntilMatchByFingerprint(pos, match);
+    }
+
     pos %= this->size;
 
-    // get entry at `pos`, and if it doesn't match `match` (e.g. because of `pos %= this->size`),
-    // iterate forward one position at a time to search for it
+    // get entries starting at `pos`, and if none of them match `match` (e.g. because of
+    // `pos %= this->size`), keep reading forward one read buffer at a time to search for it
     const ubigint origStartPos = pos;
     const bigint readBufEntryCapacity = std::min(config::ENC_IND_READ_BUF_CAPACITY, this->size);
     uchar readBuf[readBufEntryCapacity * ENTRY_LEN];
-    bigint readBufEntryCount = this->readIntoReadBuf(
-        readBuf, readBufEntryCapacity, pos, origStartPos, true
-    );
-    bigint readBufIndex = 0;
-    bool needsFseek = false;
     bigint positionsChecked = 0;
-    while (std::memcmp(readBuf + (readBufIndex * ENTRY_LEN), match, matchLen) != 0) {
-        positionsChecked++;
-        if (positionsChecked == this->size) {
-            return false;
+    while (positionsChecked < this->size) {
+        bigint readBufEntryCount = this->readIntoReadBuf(
+            readBuf, readBufEntryCapacity, pos, origStartPos
+        );
+        // scan the whole buffer at once instead of one entry at a time
+        bigint readBufIndex = this->findMatchingEntry(readBuf, readBufEntryCount, match, matchLen);
+        // key lookups can give up once they pass an empty location (which we look for only before
+        // the match, if any, as a match must come before the first empty location if it exists)
+        if (this->isTombstoneFree && matchLen == KEY_LEN) {
+            bigint emptyIndex = this->findMatchingEntry(
+                readBuf, readBufIndex, NULL_ENTRY, ENTRY_LEN
+            );
+            if (emptyIndex < readBufIndex) {
+                return false;
+            }
         }
-
-        pos = (pos + 1) % this->size;
-        if (pos == 0) {
-            // the file pointer should be in the right position from the last `fread()` into
-            // `readBuf` (and hence doesn't need an `fseek()`) IF AND ONLY IF we do not wrap around
-            // (assuming no other `fread()`s, `fwrite()`s, or `fseek()`s have occurred since then)
-            // (also, this can't be just an `fseek(0)` call here since we may only need to `fread()`
-            // to fill `readBuf` again later on, when we need to read pointer to not still be at 0)
-            needsFseek = true;
+        if (readBufIndex < readBufEntryCount) {
+            pos = (pos + readBufIndex) % this->size;
+            return true;
         }
 
-        // (this must come before we set `readBufIndex` to 0, or else we skip over an entry)
-        readBufIndex++;
-        // if we've read to the end of the current `readBuf`, read the next part of the file into it
-        if (readBufIndex >= readBufEntryCount) {
-            readBufEntryCount = this->readIntoReadBuf(
-                readBuf, readBufEntryCapacity, pos, origStartPos, needsFseek
+        positionsChecked += readBufEntryCount;
+        pos = (pos + readBufEntryCount) % this->size;
+    }
+
+    return false;
+}
+
+
+template <class Layout>
+std::vector<bool> EncIndRand<Layout>::findBatchByProbing(
+    const std::vector<std::pair<ubigint, ustring>>& posesAndKeys,
+    std::vector<EncIndVal<Layout>>& ret, bool shouldStopAtFirstMiss
+) const {
+    bigint keyCount = posesAndKeys.size();
+    std::vector<bool> isFounds(keyCount, false);
+    ret.assign(keyCount, EncIndVal<Layout> {});
+
+    // each key that is still being looked for, and how far along its probe it is
+    struct Probe {
+        bigint keyInd;
+        ubigint pos;
+        bigint positionsChecked;
+    };
+    std::vector<Probe> probes;
+    probes.reserve(keyCount);
+    for (bigint i = 0; i < keyCount; i++) {
+        probes.push_back(Probe {i, posesAndKeys[i].first % this->size, 0});
+    }
+    // (keys from here on can't be found if `shouldStopAtFirstMiss`)
+    bigint firstMissKeyInd = keyCount;
+
+    // every round reads the next window of every unfinished probe with one batch of I/O, starting
+    // with just the home positions (where most keys are) and doubling the window each round after
+    bigint windowLen = 1;
+    std::vector<uchar> windows;
+    while (!probes.empty()) {
+        std::vector<ubigint> windowPoses;
+        std::vector<bigint> windowLens;
+        windowPoses.reserve(probes.size());
+        windowLens.reserve(probes.size());
+        bigint totalWindowLen = 0;
+        for (const Probe& probe : probes) {
+            // (windows stop at the end of the file and after one full loop, like `readRaw()`s)
+            bigint currWindowLen = std::min(
+                {windowLen, this->size - (bigint)probe.pos, this->size - probe.positionsChecked}
             );
-            readBufIndex = 0;
-            needsFseek = false;
+            windowPoses.push_back(probe.pos);
+            windowLens.push_back(currWindowLen);
+            totalWindowLen += currWindowLen;
+        }
+        windows.resize(totalWindowLen * ENTRY_LEN);
+        this->readRawBatch(windowPoses, windows.data(), windowLens);
+
+        std::vector<Probe> nextProbes;
+        const uchar* window = windows.data();
+        for (bigint j = 0; j < (bigint)probes.size(); j++) {
+            Probe probe = probes[j];
+            const uchar* currWindow = window;
+            window += windowLens[j] * ENTRY_LEN;
+            if (probe.keyInd > firstMissKeyInd) {
+                continue;
+            }
+
+            const uchar* key = posesAndKeys[probe.keyInd].second.c_str();
+            bigint matchIndex = this->findMatchingEntry(currWindow, windowLens[j], key, KEY_LEN);
+            // (same early termination as `advanceUntilMatch()`)
+            bool isMiss = false;
+            if (this->isTombstoneFree) {
+                bigint emptyIndex = this->findMatchingEntry(
+                    currWindow, matchIndex, NULL_ENTRY, ENTRY_LEN
+                );
+                isMiss = emptyIndex < matchIndex;
+            }
+            if (!isMiss && matchIndex < windowLens[j]) {
+                isFounds[probe.keyInd] = true;
+                ret[probe.keyInd] = this->toEncIndVal(currWindow + (matchIndex * ENTRY_LEN));
+                continue;
+            }
+
+            probe.positionsChecked += windowLens[j];
+            if (isMiss || probe.positionsChecked >= this->size) {
+                if (shouldStopAtFirstMiss) {
+                    firstMissKeyInd = std::min(firstMissKeyInd, probe.keyInd);
+                }
+                continue;
+            }
+            probe.pos = (probe.pos + windowLens[j]) % this->size;
+            nextProbes.push_back(probe);
         }
+
+        probes.clear();
+        for (const Probe& probe : nextProbes) {
+            if (probe.keyInd < firstMissKeyInd) {
+                probes.push_back(probe);
+            }
+        }
+        windowLen = std::min(windowLen * 2, config::ENC_IND_READ_BUF_CAPACITY);
     }
 
-    return true;
+    std::fill(isFounds.begin() + std::min(firstMissKeyInd, keyCount), isFounds.end(), false);
+    return isFounds;
+}
+
+
+template <class Layout>
+bool EncIndRand<Layout>::canUseFingerprints() const {
+    return config::SHOULD_KEEP_ENC_IND_FINGERPRINTS && !this->fingerprints.empty()
+           && this->isTombstoneFree;
 }
 
 
-bigint EncIndRand::readIntoReadBuf(
-    uchar* readBuf, bigint targetEntryCount, ubigint readBufStartPos, ubigint origStartPos,
-    bool needsFseek
+template <class Layout>
+bool EncIndRand<Layout>::advanceUntilMatchByFingerprint(ubigint& pos, const uchar* key) const {
+    pos %= this->size;
+
+    const uchar keyFingerprint = calcFingerprint(key);
+    uchar currEntry[ENTRY_LEN];
+    for (bigint positionsChecked = 0; positionsChecked < this->size; positionsChecked++) {
+        uchar currFingerprint = this->fingerprints[pos];
+        if (currFingerprint == 0) {
+            return false;
+        }
+        if (currFingerprint == keyFingerprint) {
+            this->readRaw(pos, currEntry);
+            if (std::memcmp(currEntry, key, KEY_LEN) == 0) {
+                return true;
+            }
+        }
+
+        pos = (pos + 1) % this->size;
+    }
+
+    return false;
+}
+
+
+template <class Layout>
+bigint EncIndRand<Layout>::readIntoReadBuf(
+    uchar* readBuf, bigint targetEntryCount, ubigint readBufStartPos, ubigint origStartPos
 ) const {
     bigint entriesUntilEof = this->size - readBufStartPos;
     bigint entriesUntilFullLoop;
@@ -77,43 +307,44 @@ bigint EncIndRand::readIntoReadBuf(
     // the caller (e.g. if we had already wrapped around and are getting close to a full loop)
     bigint entriesToRead = std::min(targetEntryCount, entriesUntilFullLoop);
 
+    // (positional reads, so there is no shared file pointer to keep track of between calls)
     bigint entriesToReadUntilEof = std::min(entriesToRead, entriesUntilEof);
-    this->benchmark->startProfile("fseek");
-    if (needsFseek) {
-        std::fseek(this->file, readBufStartPos * ENTRY_LEN, SEEK_SET);
-    }
-    this->benchmark->stopProfile("fseek");
-    this->benchmark->startProfile("fread");
-    bigint itemsRead = std::fread(readBuf, ENTRY_LEN, entriesToReadUntilEof, this->file);
-    this->benchmark->stopProfile("fread");
-    if (itemsRead < entriesToReadUntilEof) {
-        std::cerr << "Error: EncIndRand::readIntoReadBuf(): error reading (part 1) "
-                  << "from file " << this->filename
-                  << " (only read " << itemsRead << " out of " << entriesToReadUntilEof << ")"
-                  << std::endl;
-        std::exit(EXIT_FAILURE);
-    }
+    this->readRaw(readBufStartPos, readBuf, entriesToReadUntilEof);
 
     // wrap around to beginning of file if we read less than the target number of entries
     if (entriesToReadUntilEof < entriesToRead) {
-        this->benchmark->startProfile("fseek");
-        std::fseek(this->file, 0, SEEK_SET);
-        this->benchmark->stopProfile("fseek");
-        this->benchmark->startProfile("fread");
-        itemsRead += std::fread(
-            readBuf + (entriesToReadUntilEof * ENTRY_LEN),
-            ENTRY_LEN, entriesToRead - entriesToReadUntilEof,
-            this->file
+        this->readRaw(
+            0, readBuf + (entriesToReadUntilEof * ENTRY_LEN), entriesToRead - entriesToReadUntilEof
         );
-        this->benchmark->stopProfile("fread");
-        if (itemsRead < entriesToRead) {
-            std::cerr << "Error: EncIndRand::writeToFirstEmpty(): error reading (part 2) "
-                      << "from file " << this->filename
-                      << " (only read " << itemsRead << " out of " << entriesToRead << ")"
-                      << std::endl;
-            std::exit(EXIT_FAILURE);
+    }
+
+    return entriesToRead;
+}
+
+
+template <class Layout>
+void EncIndRand<Layout>::writeRaw(ubigint pos, const uchar* buf, bigint entryCount) {
+    EncIndBase<Layout>::writeRaw(pos, buf, entryCount);
+
+    if constexpr (config::SHOULD_KEEP_ENC_IND_FINGERPRINTS) {
+        for (bigint i = 0; i < entryCount; i++) {
+            this->fingerprints[pos + i] = calcFingerprint(buf + (i * ENTRY_LEN));
         }
     }
-    
-    return itemsRead;
 }
+
+
+template <class Layout>
+uchar EncIndRand<Layout>::calcFingerprint(const uchar* key) {
+    uchar fingerprint = key[sizeof(ubigint)];
+    return fingerprint != 0 ? fingerprint : 1;
+}
+
+
+//------------------------------------------------------------------------------
+// explicit template instantiations
+
+
+template class EncIndRand<DbTupleEncIndLayout<Tuple<>>>;
+template class EncIndRand<DbTupleEncIndLayout<SrcIDb1Tuple>>;
+template class EncIndRand<CountEncIndLayout>;
@@ -1,16 +1,23 @@
 #pragma once
 
+#include <utility>
+#include <vector>
+
 #include "utils/types/basic_types.h"
 #include "utils/types/enc_ind/enc_ind_base.h"
 #include "utils/types/ustring.h"
 
 
-class EncIndRand : public EncIndBase {
+template <class Layout>
+class EncIndRand : public EncIndBase<Layout> {
 public:
+    using EncIndBase<Layout>::KEY_LEN;
+    using EncIndBase<Layout>::ENTRY_LEN;
+
     //--------------------------------------------------------------------------
     // constructors/destructors
 
-    using EncIndBase::EncIndBase;
+    using EncIndBase<Layout>::EncIndBase;
 
     //--------------------------------------------------------------------------
     // the big five
@@ -33,29 +40,92 @@ public:
     //--------------------------------------------------------------------------
     // interface
 
+    void init(bigint size) override;
+    void clear() override;
+
     // new (non-virtual override!) versions of these methods that don't change `pos` by reference,
     // as that shouldn't be needed for pseudorandom encrypted indexes and may cause bugs later
-    bool find(ubigint pos, const ustring& key, EncIndVal& ret) const {
-        return EncIndBase::find(pos, key, ret);
+    bool find(ubigint pos, const ustring& key, EncIndVal<Layout>& ret) const {
+        return EncIndBase<Layout>::find(pos, key, ret);
     }
 
-    void writeToFirstEmpty(ubigint pos, const EncIndEntry& encIndEntry) {
-        EncIndBase::writeToFirstEmpty(pos, encIndEntry);
+    void writeToFirstEmpty(ubigint pos, const EncIndEntry<Layout>& encIndEntry) {
+        EncIndBase<Layout>::writeToFirstEmpty(pos, encIndEntry);
     }
 
+    /**
+     * if fingerprints can be used (see `canUseFingerprints()`), this first finds every slot whose
+     * fingerprint matches one of the keys, then reads all of those slots with one batch of I/O;
+     * otherwise see `findBatchByProbing()`.
+     */
+    std::vector<bool> findBatch(
+        const std::vector<std::pair<ubigint, ustring>>& posesAndKeys,
+        std::vector<EncIndVal<Layout>>& ret, bool shouldStopAtFirstMiss = false
+    ) const;
+
 private:
+    using EncIndBase<Layout>::NULL_ENTRY;
+
+    // (server-side) fingerprint of the key in each slot, or `0` if the slot is empty
+    // (only kept if `config::SHOULD_KEEP_ENC_IND_FINGERPRINTS`, and only used if we have them,
+    // e.g. not if this was opened from a file saved without them)
+    std::vector<uchar> fingerprints;
+
     //--------------------------------------------------------------------------
     // helpers
 
+    EncIndType getType() const override { return EncIndType::RAND; }
+
+    /**
+     * also saves/restores `this->fingerprints` (right after the entries in the index file),
+     * so that opened indexes don't have to rebuild them.
+     */
+    void saveToHeader(EncIndHeader& header) override;
+    void openFromHeader(const EncIndHeader& header) override;
+
     bool advanceUntilMatch(ubigint& pos, const uchar* match, int matchLen) const override;
 
+    /**
+     * `findBatch()` without fingerprints: probes for all of the keys together in rounds, where each
+     * round reads the next window of entries of every key still being looked for with one batch
+     * of I/O (see `readRawBatch()`), so a batch takes about as many round trips as its longest
+     * probe needs windows instead of one probe after another.
+     */
+    std::vector<bool> findBatchByProbing(
+        const std::vector<std::pair<ubigint, ustring>>& posesAndKeys,
+        std::vector<EncIndVal<Layout>>& ret, bool shouldStopAtFirstMiss
+    ) const;
+
+    /**
+     * returns: whether lookups can go through `this->fingerprints`, i.e. if we have them and
+     * `this->isTombstoneFree` (so that a probe can stop at the first empty slot instead of
+     * walking all of them).
+     */
+    bool canUseFingerprints() const;
+
+    /**
+     * same as `advanceUntilMatch()` for `KEY_LEN` matches, but using `this->fingerprints` to only
+     * read slots that could hold `key`. since `key` can't be past the first empty slot at or after
+     * `pos`, a miss only reads the fingerprint false positives before that slot (so next to none
+     * as long as `config::ENC_IND_LOAD_FACTOR` leaves empty slots; only valid if
+     * `canUseFingerprints()`).
+     */
+    bool advanceUntilMatchByFingerprint(ubigint& pos, const uchar* key) const;
+
     /**
      * returns: final entry count of `readBuf` (which may not be `readbufEntryCount` if the
      * buffer size does not divide enc ind size and there is a bit left over, for example).
      */
     bigint readIntoReadBuf(
-        uchar* readBuf, bigint targetEntryCount, ubigint readBufStartPos, ubigint origStartPos,
-        bool needsFseek
+        uchar* readBuf, bigint targetEntryCount, ubigint readBufStartPos, ubigint origStartPos
     ) const;
+
+    void writeRaw(ubigint pos, const uchar* buf, bigint entryCount = 1) override;
+
+    /**
+     * returns: a nonzero one-byte fingerprint of `key` (taken from past the bytes that
+     * `utils::misc::hashToPos()` uses, so that it is independent of the key's home position).
+     */
+    static uchar calcFingerprint(const uchar* key);
 };
 
@@ -0,0 +1,176 @@
+#include "utils/types/enc_ind/enc_ind_robin_hood.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "config.h"
+
+#include "utils/types/basic_types.h"
+#include "utils/types/enc_ind/enc_ind_base.h"
+#include "utils/types/enc_ind/enc_ind_utils.h"
+#include "utils/types/tuple.h"
+#include "utils/types/ustring.h"
+
+
+//------------------------------------------------------------------------------
+// interface
+
+
+template <class Layout>
+void EncIndRobinHood<Layout>::init(bigint size) {
+    EncIndBase<Layout>::init(size);
+
+    this->maxDisplacement = 0;
+}
+
+
+template <class Layout>
+void EncIndRobinHood<Layout>::clear() {
+    EncIndBase<Layout>::clear();
+
+    this->maxDisplacement = 0;
+}
+
+
+template <class Layout>
+void EncIndRobinHood<Layout>::writeToFirstEmpty(
+    ubigint pos, const EncIndEntry<Layout>& encIndEntry
+) {
+    pos %= this->size;
+
+    // the entry we are currently trying to place (which changes whenever we evict someone)
+    EncIndEntry<Layout> carriedEntry = encIndEntry;
+    bigint carriedDisplacement = 0;
+
+    const bigint readBufEntryCapacity = std::min(config::ENC_IND_READ_BUF_CAPACITY, this->size);
+    uchar readBuf[readBufEntryCapacity * ENTRY_LEN];
+    for (bigint positionsChecked = 0; positionsChecked < this->size; positionsChecked++) {
+        // (never read more than the rest of one full loop, so `readBuf` never holds a stale copy
+        // of an entry we've already overwritten)
+        bigint readBufIndex = positionsChecked % readBufEntryCapacity;
+        if (readBufIndex == 0) {
+            this->readRawWrapping(
+                pos, readBuf, std::min(readBufEntryCapacity, this->size - positionsChecked)
+            );
+        }
+        uchar* currEntry = readBuf + (readBufIndex * ENTRY_LEN);
+
+        if (std::memcmp(currEntry, NULL_ENTRY, ENTRY_LEN) == 0) {
+            this->writeRaw(pos, carriedEntry.data());
+            this->maxDisplacement = std::max(this->maxDisplacement, carriedDisplacement);
+            return;
+        }
+
+        // "steal from the rich": if the occupant is closer to home than we are, take its slot
+        // and carry it forward instead
+        bigint currDisplacement = this->calcDisplacement(currEntry, pos);
+        if (currDisplacement < carriedDisplacement) {
+            this->writeRaw(pos, carriedEntry.data());
+            this->maxDisplacement = std::max(this->maxDisplacement, carriedDisplacement);
+
+            EncIndEntry<Layout> evictedEntry;
+            std::memcpy(evictedEntry.data(), currEntry, ENTRY_LEN);
+            std::memcpy(currEntry, carriedEntry.data(), ENTRY_LEN);
+            carriedEntry = evictedEntry;
+            carriedDisplacement = currDisplacement;
+        }
+
+        pos = (pos + 1) % this->size;
+        carriedDisplacement++;
+    }
+
+    // if we've scoured the whole index and still haven't found an available space,
+    // throw an error: we are trying to write to a full index
+    std::cerr << "Error: EncIndRobinHood::writeToFirstEmpty(): ran out of space writing to "
+              << this->filename << std::endl;
+    std::exit(EXIT_FAILURE);
+}
+
+
+//------------------------------------------------------------------------------
+// helpers
+
+
+template <class Layout>
+void EncIndRobinHood<Layout>::saveToHeader(EncIndHeader& header) {
+    EncIndBase<Layout>::saveToHeader(header);
+
+    header.maxDisplacement = this->maxDisplacement;
+}
+
+
+template <class Layout>
+void EncIndRobinHood<Layout>::openFromHeader(const EncIndHeader& header) {
+    EncIndBase<Layout>::openFromHeader(header);
+
+    this->maxDisplacement = header.maxDisplacement;
+}
+
+
+template <class Layout>
+bool EncIndRobinHood<Layout>::advanceUntilMatch(
+    ubigint& pos, const uchar* match, int matchLen
+) const {
+    pos %= this->size;
+
+    // no entry is ever further than `this->maxDisplacement` from its home, so that many entries
+    // (plus the home position itself) is all we ever have to look at
+    const bigint probeLimit = std::min(this->maxDisplacement + 1, this->size);
+    const bigint readBufEntryCapacity = std::min(config::ENC_IND_READ_BUF_CAPACITY, probeLimit);
+    uchar readBuf[readBufEntryCapacity * ENTRY_LEN];
+    for (bigint displacement = 0; displacement < probeLimit; displacement++) {
+        bigint readBufIndex = displacement % readBufEntryCapacity;
+        if (readBufIndex == 0) {
+            this->readRawWrapping(
+                pos, readBuf, std::min(readBufEntryCapacity, probeLimit - displacement)
+            );
+        }
+        const uchar* currEntry = readBuf + (readBufIndex * ENTRY_LEN);
+
+        if (std::memcmp(currEntry, match, matchLen) == 0) {
+            return true;
+        }
+        // an empty slot, or an occupant closer to its home than `match` would be to its own,
+        // means that insertion would have placed `match` here, so it can't be any further along
+        if (std::memcmp(currEntry, NULL_ENTRY, ENTRY_LEN) == 0
+                || this->calcDisplacement(currEntry, pos) < displacement) {
+            return false;
+        }
+
+        pos = (pos + 1) % this->size;
+    }
+
+    return false;
+}
+
+
+template <class Layout>
+bigint EncIndRobinHood<Layout>::calcDisplacement(const uchar* entry, ubigint pos) const {
+    // (same as `utils::misc::hashToPos()` on the key, but without copying it into a `ustring`)
+    ubigint homePos;
+    std::memcpy(&homePos, entry, sizeof(ubigint));
+    homePos %= this->size;
+
+    return (pos + this->size - homePos) % this->size;
+}
+
+
+template <class Layout>
+void EncIndRobinHood<Layout>::readRawWrapping(ubigint pos, uchar* buf, bigint entryCount) const {
+    bigint entriesUntilEof = std::min(entryCount, this->size - (bigint)pos);
+    this->readRaw(pos, buf, entriesUntilEof);
+    if (entriesUntilEof < entryCount) {
+        this->readRaw(0, buf + (entriesUntilEof * ENTRY_LEN), entryCount - entriesUntilEof);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// explicit template instantiations
+
+
+template class EncIndRobinHood<DbTupleEncIndLayout<Tuple<>>>;
+template class EncIndRobinHood<DbTupleEncIndLayout<SrcIDb1Tuple>>;
+template class EncIndRobinHood<CountEncIndLayout>;
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "utils/types/basic_types.h"
+#include "utils/types/enc_ind/enc_ind_base.h"
+#include "utils/types/ustring.h"
+
+
+/**
+ * pseudorandom encrypted index like `EncIndRand`, but using Robin Hood hashing: on insertion,
+ * an entry that is further from its home position than the entry currently occupying a slot
+ * takes that slot and the occupant is pushed forward instead. this keeps the spread of probe
+ * lengths tight even at high load factors, and lets lookups stop early: after
+ * `this->maxDisplacement + 1` entries, or at the first entry closer to its home than we are
+ * to ours.
+ *
+ * preconditions:
+ *     - the `pos` passed in for every entry must be `utils::misc::hashToPos()` of its key (as
+ *       is the case for PiBas and NLogN's keyword count dictionary), since we need to recover
+ *       each stored entry's home position from its key alone.
+ */
+template <class Layout>
+class EncIndRobinHood : public EncIndBase<Layout> {
+public:
+    using EncIndBase<Layout>::KEY_LEN;
+    using EncIndBase<Layout>::ENTRY_LEN;
+
+    //--------------------------------------------------------------------------
+    // constructors/destructors
+
+    using EncIndBase<Layout>::EncIndBase;
+
+    //--------------------------------------------------------------------------
+    // the big five
+
+    // destructor
+    ~EncIndRobinHood() = default;
+
+    // copy constructor
+    EncIndRobinHood(const EncIndRobinHood& other) = default;
+
+    // copy assignment operator
+    EncIndRobinHood& operator =(const EncIndRobinHood& other) = default;
+
+    // move constructor
+    EncIndRobinHood(EncIndRobinHood&& other) noexcept = default;
+
+    // move assignment operator
+    EncIndRobinHood& operator =(EncIndRobinHood&& other) noexcept = default;
+
+    //--------------------------------------------------------------------------
+    // interface
+
+    void init(bigint size) override;
+    void clear() override;
+
+    // same signatures as `EncIndRand` so that the two are interchangeable (see `enc_ind_dict.h`)
+    bool find(ubigint pos, const ustring& key, EncIndVal<Layout>& ret) const {
+        return EncIndBase<Layout>::find(pos, key, ret);
+    }
+
+    /**
+     * Robin Hood insertion starting at `pos`: this may move existing entries forward,
+     * so (unlike with `EncIndRand`) the location of an entry is only stable once setup is done.
+     */
+    void writeToFirstEmpty(ubigint pos, const EncIndEntry<Layout>& encIndEntry);
+
+    bigint getMaxDisplacement() const { return this->maxDisplacement; }
+
+private:
+    using EncIndBase<Layout>::NULL_ENTRY;
+
+    // longest distance of any entry from its home position, which bounds every lookup
+    bigint maxDisplacement = 0;
+
+    //--------------------------------------------------------------------------
+    // helpers
+
+    EncIndType getType() const override { return EncIndType::ROBIN_HOOD; }
+    void saveToHeader(EncIndHeader& header) override;
+    void openFromHeader(const EncIndHeader& header) override;
+
+    bool advanceUntilMatch(ubigint& pos, const uchar* match, int matchLen) const override;
+
+    /**
+     * distance of the (non-null) raw entry stored at `pos` from its home position.
+     */
+    bigint calcDisplacement(const uchar* entry, ubigint pos) const;
+
+    /**
+     * like `readRaw()`, but wraps around to the start of the index if needed
+     * (`entryCount` must not exceed `this->size`).
+     */
+    void readRawWrapping(ubigint pos, uchar* buf, bigint entryCount) const;
+};
@@ -1,16 +1,68 @@
 #include "utils/types/enc_ind/enc_ind_utils.h"
 
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "config.h"
+
+#include "utils/crypto.h"
+#include "utils/types/basic_types.h"
+#include "utils/types/tuple.h"
 #include "utils/types/ustring.h"
 
 
 namespace utils::enc_ind {
 
 
-ustring toUstr(const EncIndEntry& encIndEntry) {
-    ustring key = encIndEntry.first;
-    EncIndVal val = encIndEntry.second;
-    return key + val.first + val.second;
+template <class Layout>
+ustring toUstr(const EncIndEntry<Layout>& encIndEntry) {
+    return ustring(encIndEntry.data(), Layout::ENTRY_LEN);
+}
+
+
+template <class Layout>
+EncIndEntry<Layout> toEncIndEntry(const ustring& key, const ustring& encData, const ustring& iv) {
+    if (key.length() != Layout::KEY_LEN || encData.length() != Layout::DATA_LEN
+            || iv.length() != utils::crypto::IV_LEN) {
+        std::cerr << "Error: utils::enc_ind::toEncIndEntry(): entry of length "
+                  << key.length() + encData.length() + iv.length()
+                  << " bytes is not allowed! (want " << Layout::ENTRY_LEN << " bytes)"
+                  << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    EncIndEntry<Layout> encIndEntry;
+    std::memcpy(encIndEntry.key.data(), key.c_str(), Layout::KEY_LEN);
+    std::memcpy(encIndEntry.val.encData.data(), encData.c_str(), Layout::DATA_LEN);
+    std::memcpy(encIndEntry.val.iv.data(), iv.c_str(), utils::crypto::IV_LEN);
+    return encIndEntry;
+}
+
+
+bigint calcSizeForLoadFactor(bigint entryCount) {
+    return std::ceil(entryCount / config::ENC_IND_LOAD_FACTOR);
 }
 
 
+//------------------------------------------------------------------------------
+// explicit template instantiations
+
+
+template ustring toUstr(const EncIndEntry<DbTupleEncIndLayout<Tuple<>>>& encIndEntry);
+template ustring toUstr(const EncIndEntry<DbTupleEncIndLayout<SrcIDb1Tuple>>& encIndEntry);
+template ustring toUstr(const EncIndEntry<CountEncIndLayout>& encIndEntry);
+
+template EncIndEntry<DbTupleEncIndLayout<Tuple<>>> toEncIndEntry(
+    const ustring& key, const ustring& encData, const ustring& iv
+);
+template EncIndEntry<DbTupleEncIndLayout<SrcIDb1Tuple>> toEncIndEntry(
+    const ustring& key, const ustring& encData, const ustring& iv
+);
+template EncIndEntry<CountEncIndLayout> toEncIndEntry(
+    const ustring& key, const ustring& encData, const ustring& iv
+);
+
+
 } // namespace `utils::enc_ind`
@@ -1,22 +1,202 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <new>
+#include <span>
 #include <utility>
+#include <vector>
 
+#include "config.h"
+
+#include "utils/crypto.h"
+#include "utils/types/basic_types.h"
+#include "utils/types/tuple.h"
 #include "utils/types/ustring.h"
 
 
+namespace utils::enc_ind {
+
+
+// (both PRF (default) and hash (res-hiding) have 512 bit output)
+inline constexpr int KEY_LEN = utils::crypto::HASH_OUTPUT_LEN;
+
+
+/**
+ * returns: length of the ciphertext of a plaintext of at most `maxPlaintextLen` bytes (once it is
+ * padded to the same length as every other one in its index), i.e. the next whole number of AES
+ * blocks. (encrypting an exactly n block length plaintext with AES should produce the exact same
+ * block ciphertext, but we actually must restrict our plaintexts by one more byte or else AES'
+ * PCKS #7 padding will generate an extra block if our plaintext is exactly an integer number of
+ * blocks long, thus the `+1`.)
+ */
+constexpr int calcDataLen(int maxPlaintextLen) {
+    return (maxPlaintextLen + 1 + utils::crypto::BLOCK_SIZE - 1) / utils::crypto::BLOCK_SIZE
+        * utils::crypto::BLOCK_SIZE;
+}
+
+
+} // namespace `utils::enc_ind`
+
+
+/**
+ * compile-time entry format of an encrypted index whose encrypted data are plaintexts of at most
+ * `MAX_PLAINTEXT_LEN` bytes, so that every kind of index only takes as many AES blocks per entry
+ * as its payload needs (e.g. NLogN's keyword count dictionary only needs one, while tuples need
+ * several). encrypted indexes (and their entries) are templated on this.
+ */
+template <int MAX_PLAINTEXT_LEN>
+struct EncIndLayout {
+    inline static constexpr int KEY_LEN   = utils::enc_ind::KEY_LEN;
+    inline static constexpr int DATA_LEN  = utils::enc_ind::calcDataLen(MAX_PLAINTEXT_LEN);
+    inline static constexpr int VAL_LEN   = DATA_LEN + utils::crypto::IV_LEN;
+    inline static constexpr int ENTRY_LEN = KEY_LEN + VAL_LEN;
+};
+
+// layout for indexes of `DbTuple`s (which are encrypted from their `toStr()`)
+template <IsDbTuple DbTuple>
+using DbTupleEncIndLayout = EncIndLayout<DbTuple::MAX_STR_LEN>;
+
+// layout for indexes of counts (e.g. NLogN's keyword count dictionary)
+using CountEncIndLayout = EncIndLayout<config::MAX_VALUE_DIGITS>;
+
+
+/**
+ * encrypted indexes are a collection of fixed-size `EncIndEntry`s, corresponding to
+ * `(key, (encrypted data, IV))`. these are plain arrays of bytes laid out exactly like an entry
+ * on disk, so they can be read and written directly without any encoding or heap allocations.
+ */
+template <class Layout>
+struct EncIndVal {
+    std::array<uchar, Layout::DATA_LEN> encData;
+    std::array<uchar, utils::crypto::IV_LEN> iv;
+};
+
+template <class Layout>
+struct EncIndEntry {
+    std::array<uchar, Layout::KEY_LEN> key;
+    EncIndVal<Layout> val;
+
+    const uchar* data() const { return reinterpret_cast<const uchar*>(this); }
+    uchar* data() { return reinterpret_cast<uchar*>(this); }
+};
+
+static_assert(sizeof(EncIndVal<DbTupleEncIndLayout<Tuple<>>>)
+    == DbTupleEncIndLayout<Tuple<>>::VAL_LEN);
+static_assert(sizeof(EncIndEntry<DbTupleEncIndLayout<Tuple<>>>)
+    == DbTupleEncIndLayout<Tuple<>>::ENTRY_LEN);
+static_assert(sizeof(EncIndEntry<CountEncIndLayout>) == CountEncIndLayout::ENTRY_LEN);
+
+
 /**
- * encrypted indexes are a collection of `std::pair<ustring, std::pair<ustring, ustring>>`
- * (aka `EncIndEntry`) pairs, corresponding to `std::pair<key, std::pair<encrypted data, IV>>`.
+ * non-owning view of an `EncIndVal` directly inside a buffer of raw entries (e.g. a whole bucket
+ * read at once), so that reading results doesn't need to copy each one into two new `ustring`s.
+ * (only valid for as long as the buffer it points into is!)
  */
-using EncIndVal   = std::pair<ustring, ustring>;
-using EncIndEntry = std::pair<ustring, EncIndVal>;
+struct EncIndValView {
+    std::span<const uchar> encData;
+    std::span<const uchar> iv;
+
+    EncIndValView() = default;
+    EncIndValView(std::span<const uchar> encData, std::span<const uchar> iv)
+            : encData(encData), iv(iv) {}
+    template <class Layout>
+    EncIndValView(const EncIndVal<Layout>& encIndVal)
+            : encData(encIndVal.encData), iv(encIndVal.iv) {}
+};
+
+
+/**
+ * which kind of encrypted index a saved index file holds.
+ */
+enum class EncIndType : ubigint {
+    RAND       = 1,
+    ROBIN_HOOD = 2,
+    LOC        = 3
+};
+
+
+/**
+ * header at the start of every saved encrypted index file (see `EncIndBase::save()`), which takes
+ * up the whole first page of the file so that entries stay page-aligned. fields that don't apply
+ * to a given `type` are left as `0`.
+ */
+struct EncIndHeader {
+    char magic[8];
+    ubigint formatVersion;
+    EncIndType type;
+    // (entry format of the build that wrote this, which must match ours)
+    bigint keyLen;
+    bigint dataLen;
+    bigint ivLen;
+
+    bigint size;
+    bigint isTombstoneFree;
+    // (`EncIndLoc` only)
+    bigint bcktSize;
+    bigint bcktCount;
+    bigint isBcktAligned;
+    bigint bcktStrideLen;
+    // (`EncIndRobinHood` only)
+    bigint maxDisplacement;
+    // (`EncIndRand` only: length of the key fingerprints saved right after the entries, if any)
+    bigint fingerprintsLen;
+};
 
 
 namespace utils::enc_ind {
 
 
-ustring toUstr(const EncIndEntry& encIndEntry);
+inline constexpr bigint PAGE_LEN = 4096;
+
+inline constexpr char FILE_MAGIC[8] = {'S', 'S', 'E', 'E', 'N', 'C', 'I', 'D'};
+// (bump this whenever the layout of saved index files changes)
+inline constexpr ubigint FILE_FORMAT_VERSION = 1;
+
+
+/**
+ * minimal allocator for page-aligned buffers (as needed for e.g. `O_DIRECT` reads).
+ */
+template <class T>
+struct PageAlignedAllocator {
+    using value_type = T;
+
+    PageAlignedAllocator() = default;
+    template <class U>
+    PageAlignedAllocator(const PageAlignedAllocator<U>& other) {}
+
+    T* allocate(std::size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t {PAGE_LEN}));
+    }
+
+    void deallocate(T* ptr, std::size_t count) {
+        ::operator delete(ptr, count * sizeof(T), std::align_val_t {PAGE_LEN});
+    }
+
+    template <class U>
+    bool operator ==(const PageAlignedAllocator<U>& other) const { return true; }
+};
+
+
+template <class Layout>
+ustring toUstr(const EncIndEntry<Layout>& encIndEntry);
+
+/**
+ * pack `key`, `encData`, and `iv` (e.g. straight out of `utils::crypto`) into an entry,
+ * exiting if any of them is not exactly the right length for `Layout`.
+ */
+template <class Layout>
+EncIndEntry<Layout> toEncIndEntry(const ustring& key, const ustring& encData, const ustring& iv);
+
+/**
+ * returns: the size a pseudorandom encrypted index needs so that `entryCount` entries
+ * fill it up to `config::ENC_IND_LOAD_FACTOR`.
+ */
+bigint calcSizeForLoadFactor(bigint entryCount);
 
 
 } // namespace `utils::enc_ind`
+
+
+// reusable, page-aligned buffer of raw entries
+using EncIndBuf = std::vector<uchar, utils::enc_ind::PageAlignedAllocator<uchar>>;
@@ -1,22 +1,86 @@
 #include "utils/types/i_disk_storage.h"
 
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <format>
 #include <iostream>
+#include <mutex>
 #include <random>
 #include <string>
+#include <system_error>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "utils/async_io.h"
 #include "utils/random.h"
 #include "utils/types/basic_types.h"
+#include "utils/types/ustring.h"
 
 
 namespace {
 
 
-std::uniform_int_distribution<ubigint> dist;
+/**
+ * emptied temporary files (and their still-open `FILE*`s) waiting to be reused by `init()`,
+ * grouped by `FILE_DIR()/FILENAME_PREFIX()`; whatever is left over is deleted at exit.
+ */
+class FilePool {
+public:
+    ~FilePool() {
+        for (auto& [prefix, files] : this->pooledFiles) {
+            for (auto& [file, filename] : files) {
+                std::fclose(file);
+                std::error_code errorCode;
+                std::filesystem::remove(filename, errorCode);
+            }
+        }
+    }
+
+    /**
+     * returns: whether `file` (which must already be emptied) was taken.
+     */
+    bool put(const std::string& prefix, bigint capacity, FILE* file, const std::string& filename) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        std::vector<std::pair<FILE*, std::string>>& files = this->pooledFiles[prefix];
+        if ((bigint)files.size() >= capacity) {
+            return false;
+        }
+        files.push_back(std::pair {file, filename});
+        return true;
+    }
+
+    /**
+     * returns: whether there was a file to reuse (if so, it is in `file` and `filename`).
+     */
+    bool take(const std::string& prefix, FILE*& file, std::string& filename) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto iter = this->pooledFiles.find(prefix);
+        if (iter == this->pooledFiles.end() || iter->second.empty()) {
+            return false;
+        }
+        file = iter->second.back().first;
+        filename = iter->second.back().second;
+        iter->second.pop_back();
+        return true;
+    }
+
+private:
+    std::mutex mutex;
+    std::unordered_map<std::string, std::vector<std::pair<FILE*, std::string>>> pooledFiles;
+};
+
+
+FilePool& getFilePool() {
+    static FilePool pool;
+    return pool;
+}
 
 
 } // anonymous namespace
@@ -58,8 +122,9 @@ void IDiskStorage::copyFrom(const IDiskStorage& other) {
     }
 
     // open the file we just copied
-    // (we use `a` instead of `w` mode here to not overwrite the file we just copied)
-    this->file = std::fopen(this->filename.c_str(), "ab+");
+    // (we use `r+` instead of `w` mode here to not overwrite the file we just copied, and instead
+    // of `a` since `O_APPEND` makes `pwrite()` ignore its offset and always write at the end)
+    this->file = std::fopen(this->filename.c_str(), "rb+");
     if (this->file == nullptr) {
         std::cerr << "Error: IDiskStorage::copyFrom(): error opening file " << this->filename
                   << std::endl;
@@ -79,6 +144,19 @@ void IDiskStorage::moveFrom(IDiskStorage&& other) noexcept {
     other.filename = "";
 
     this->isFlushed = other.isFlushed;
+
+    this->isPersistent = other.isPersistent;
+    other.isPersistent = false;
+
+    this->isRecyclable = other.isRecyclable;
+    other.isRecyclable = false;
+
+    this->mapping = other.mapping;
+    other.mapping = nullptr;
+    this->mappingLen = other.mappingLen;
+    other.mappingLen = 0;
+    // (moving a vector keeps its buffer, so `this->mapping` still points into it if it did before)
+    this->ramCopy = std::move(other.ramCopy);
 }
 
 
@@ -117,6 +195,16 @@ IDiskStorage& IDiskStorage::operator =(IDiskStorage&& other) noexcept {
 void IDiskStorage::init() {
     this->clear();
 
+    // reuse an (already emptied) file let go of by an earlier `clear()` if there is one
+    if (this->FILE_POOL_CAPACITY() > 0) {
+        std::string prefix = this->FILE_DIR() + "/" + this->FILENAME_PREFIX();
+        if (::getFilePool().take(prefix, this->file, this->filename)) {
+            this->isFlushed = true;
+            this->isRecyclable = true;
+            return;
+        }
+    }
+
     // first make sure base directory exists
     try {
         std::filesystem::create_directories(this->FILE_DIR());
@@ -139,27 +227,150 @@ void IDiskStorage::init() {
                   << std::endl;
         std::exit(EXIT_FAILURE);
     }
+    this->isRecyclable = true;
 }
 
 
 void IDiskStorage::clear() {
+    this->unmap();
+
+    // empty out the file and hand it to the pool instead of deleting it if we can
+    // (truncating frees its disk space right away, and leaves it just like a new file)
+    if (this->file != nullptr && this->isRecyclable && !this->isPersistent
+            && this->FILE_POOL_CAPACITY() > 0) {
+        std::fflush(this->file);
+        std::rewind(this->file);
+        std::string prefix = this->FILE_DIR() + "/" + this->FILENAME_PREFIX();
+        if (::ftruncate(::fileno(this->file), 0) == 0 && ::getFilePool().put(
+            prefix, this->FILE_POOL_CAPACITY(), this->file, this->filename
+        )) {
+            this->file = nullptr;
+            this->filename = "";
+        }
+    }
+    this->isRecyclable = false;
+
     // close file descriptors
     if (this->file != nullptr) {
         std::fclose(this->file);
         this->file = nullptr;
     }
 
-    // delete file from disk
+    // delete file from disk (unless it's persistent, in which case we just let go of it)
     if (this->filename != "") {
-        try {
-            std::filesystem::remove(this->filename);
-        } catch (const std::filesystem::filesystem_error& e) {
-            std::cerr << "Error: IDiskStorage::clear(): error removing file " << this->filename
-                      << ": " << e.what() << std::endl;
-            std::exit(EXIT_FAILURE);
+        if (!this->isPersistent) {
+            try {
+                std::filesystem::remove(this->filename);
+            } catch (const std::filesystem::filesystem_error& e) {
+                std::cerr << "Error: IDiskStorage::clear(): error removing file "
+                          << this->filename << ": " << e.what() << std::endl;
+                std::exit(EXIT_FAILURE);
+            }
         }
         this->filename = "";
+        this->isPersistent = false;
+    }
+}
+
+
+void IDiskStorage::saveAs(const std::string& filename) {
+    if (!this->isFlushed) {
+        std::fflush(this->file);
+        this->isFlushed = true;
+    }
+    if (::fsync(::fileno(this->file)) != 0) {
+        std::cerr << "Error: IDiskStorage::saveAs(): error syncing file " << this->filename
+                  << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    // (renaming keeps our open file pointer valid, so there's nothing to reopen)
+    std::error_code ec;
+    std::filesystem::rename(this->filename, filename, ec);
+    if (ec == std::errc::cross_device_link) {
+        // `filename` is on another filesystem, so copy the file over instead, and switch our file
+        // pointer over to the copy since the original is about to go away
+        ec.clear();
+        std::filesystem::copy_file(
+            this->filename, filename, std::filesystem::copy_options::overwrite_existing, ec
+        );
+        if (!ec) {
+            FILE* copiedFile = std::fopen(filename.c_str(), "rb+");
+            if (copiedFile == nullptr || ::fsync(::fileno(copiedFile)) != 0) {
+                std::cerr << "Error: IDiskStorage::saveAs(): error syncing copied file "
+                          << filename << std::endl;
+                std::exit(EXIT_FAILURE);
+            }
+            std::fclose(this->file);
+            this->file = copiedFile;
+            std::filesystem::remove(this->filename, ec);
+        }
+    }
+    if (ec) {
+        std::cerr << "Error: IDiskStorage::saveAs(): error moving file " << this->filename
+                  << " to " << filename << ": " << ec.message() << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    this->filename = filename;
+    this->isPersistent = true;
+}
+
+
+void IDiskStorage::open(const std::string& filename) {
+    this->clear();
+
+    this->file = std::fopen(filename.c_str(), "rb");
+    if (this->file == nullptr) {
+        std::cerr << "Error: IDiskStorage::open(): error opening file " << filename << std::endl;
+        std::exit(EXIT_FAILURE);
     }
+    this->filename = filename;
+    this->isFlushed = true;
+    this->isPersistent = true;
+}
+
+
+void IDiskStorage::mapReadOnly(bool shouldPopulate) {
+    if (!this->isPersistent) {
+        std::cerr << "Error: IDiskStorage::mapReadOnly(): " << this->filename << " is still being "
+                  << "written to (only files from `open()` can be mapped)" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    bigint fileLen = std::filesystem::file_size(this->filename);
+    void* mapping = ::mmap(
+        nullptr, fileLen, PROT_READ, MAP_SHARED | (shouldPopulate ? MAP_POPULATE : 0),
+        ::fileno(this->file), 0
+    );
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Error: IDiskStorage::mapReadOnly(): error mapping file " << this->filename
+                  << " (" << std::strerror(errno) << ")" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    // (lookups are all over the place, so readahead would mostly fetch pages we never touch)
+    if (!shouldPopulate) {
+        ::madvise(mapping, fileLen, MADV_RANDOM);
+    }
+
+    this->mapping = static_cast<const uchar*>(mapping);
+    this->mappingLen = fileLen;
+}
+
+
+void IDiskStorage::loadIntoRam() {
+    if (!this->isFlushed) {
+        std::fflush(this->file);
+        this->isFlushed = true;
+    }
+
+    // (read through any existing mapping first, then drop it in favor of our copy)
+    std::vector<uchar> ramCopy(std::filesystem::file_size(this->filename));
+    this->readAt(ramCopy.data(), ramCopy.size(), 0);
+    this->unmap();
+
+    this->ramCopy = std::move(ramCopy);
+    this->mapping = this->ramCopy.data();
+    this->mappingLen = this->ramCopy.size();
 }
 
 
@@ -167,9 +378,84 @@ void IDiskStorage::clear() {
 // helpers
 
 
+void IDiskStorage::unmap() {
+    if (this->mapping != nullptr && this->ramCopy.empty()) {
+        ::munmap(const_cast<uchar*>(this->mapping), this->mappingLen);
+    }
+    this->mapping = nullptr;
+    this->mappingLen = 0;
+    this->ramCopy = std::vector<uchar> {};
+}
+
+
 std::string IDiskStorage::genFilename() const {
     // avoid naming clashes by generating a random 8 byte (16 char) hex string
-    ubigint randomHex = ::dist(utils::random::RNG);
+    std::uniform_int_distribution<ubigint> dist;
+    ubigint randomHex = dist(utils::random::RNG);
     std::string randomHexStr = std::format("{:016x}", randomHex);
     return std::format("{}/{}{}.dat", this->FILE_DIR(), this->FILENAME_PREFIX(), randomHexStr);
 }
+
+
+void IDiskStorage::readAt(void* buf, bigint len, bigint offset) const {
+    if (this->mapping != nullptr) {
+        if (offset + len > this->mappingLen) {
+            std::cerr << "Error: IDiskStorage::readAt(): reading past the end of file "
+                      << this->filename << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        std::memcpy(buf, this->mapping + offset, len);
+        return;
+    }
+
+    // (`pread()` may return fewer bytes than asked for, so keep going until we have all of them)
+    bigint bytesRead = 0;
+    while (bytesRead < len) {
+        ssize_t res = ::pread(
+            ::fileno(this->file), static_cast<char*>(buf) + bytesRead, len - bytesRead,
+            offset + bytesRead
+        );
+        if (res <= 0) {
+            std::cerr << "Error: IDiskStorage::readAt(): error reading from file " << this->filename
+                      << " (only read " << bytesRead << " out of " << len << " bytes)" << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        bytesRead += res;
+    }
+}
+
+
+void IDiskStorage::writeAt(const void* buf, bigint len, bigint offset) {
+    bigint bytesWritten = 0;
+    while (bytesWritten < len) {
+        ssize_t res = ::pwrite(
+            ::fileno(this->file), static_cast<const char*>(buf) + bytesWritten, len - bytesWritten,
+            offset + bytesWritten
+        );
+        if (res <= 0) {
+            std::cerr << "Error: IDiskStorage::writeAt(): error writing to file " << this->filename
+                      << " (only wrote " << bytesWritten << " out of " << len << " bytes)"
+                      << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        bytesWritten += res;
+    }
+}
+
+
+void IDiskStorage::readAtBatch(std::vector<utils::async_io::IoReq>& reqs) const {
+    // (nothing to have in flight if it's all already in memory)
+    if (this->mapping != nullptr) {
+        for (const utils::async_io::IoReq& req : reqs) {
+            this->readAt(req.buf, req.len, req.offset);
+        }
+        return;
+    }
+
+    int fd = ::fileno(this->file);
+    for (utils::async_io::IoReq& req : reqs) {
+        req.fd = fd;
+        req.isWrite = false;
+    }
+    utils::async_io::submitAndWait(reqs);
+}
@@ -2,6 +2,11 @@
 
 #include <cstdio>
 #include <string>
+#include <vector>
+
+#include "utils/async_io.h"
+#include "utils/types/basic_types.h"
+#include "utils/types/ustring.h"
 
 
 class IDiskStorage {
@@ -47,6 +52,36 @@ public:
     virtual void init();
     virtual void clear();
 
+    /**
+     * move this object's file to `filename` (overwriting anything already there) and make sure
+     * it has hit the disk, after which the file is persistent: `clear()` and the destructor
+     * just close it instead of deleting it.
+     */
+    void saveAs(const std::string& filename);
+
+    /**
+     * replace this object's file with the existing persistent file `filename`
+     * (opened read-only).
+     */
+    void open(const std::string& filename);
+
+    /**
+     * map the whole of this object's (persistent, read-only) file into memory with
+     * `mmap(PROT_READ)`, after which all reads are served straight from the mapping with no
+     * syscalls, and any number of processes mapping the same file share one page cache copy.
+     * if `shouldPopulate`, all pages are faulted in up front (`MAP_POPULATE`); otherwise they
+     * are paged in lazily on first access.
+     */
+    void mapReadOnly(bool shouldPopulate);
+
+    /**
+     * read the whole of this object's file into memory, after which all reads are served from
+     * that copy (like `mapReadOnly()`, but the contents stay resident no matter what happens to
+     * the page cache). nothing should be written to the file afterwards, since those writes
+     * wouldn't show up in the copy.
+     */
+    void loadIntoRam();
+
     //--------------------------------------------------------------------------
     // debugging
 
@@ -58,6 +93,15 @@ protected:
     std::string filename = "";
     // (`mutable` allows this to be modified in `const` contexts still, which we do need for reads)
     mutable bool isFlushed = true;
+    // whether `this->file` outlives us (see `saveAs()`) instead of being a temporary file
+    bool isPersistent = false;
+    // whether `this->file` was created by `init()` (and so can be handed to another `init()`)
+    bool isRecyclable = false;
+    // read-only mapping of `this->file` from `mapReadOnly()`, if any
+    // (or of `this->ramCopy`, if we did `loadIntoRam()`)
+    const uchar* mapping = nullptr;
+    bigint mappingLen = 0;
+    std::vector<uchar> ramCopy;
 
     //--------------------------------------------------------------------------
     // methods to implement
@@ -65,8 +109,43 @@ protected:
     virtual constexpr std::string FILE_DIR() const = 0;
     virtual constexpr std::string FILENAME_PREFIX() const = 0;
 
+    /**
+     * max number of files let go of by `clear()` to keep around (emptied) for later `init()`s
+     * of the same kind of storage to reuse, instead of deleting them and creating new ones.
+     *
+     * (children that enable this must also call `clear()` in their own destructor, since the
+     * `IDiskStorage` destructor can no longer see this override.)
+     */
+    virtual constexpr bigint FILE_POOL_CAPACITY() const { return 0; }
+
     //--------------------------------------------------------------------------
     // helpers
 
     std::string genFilename() const;
+
+    /**
+     * let go of the mapping from `mapReadOnly()` or the copy from `loadIntoRam()`, if any,
+     * so that reads go back to the file.
+     */
+    void unmap();
+
+    /**
+     * positional reads and writes of `len` bytes at byte offset `offset` (via `pread()` and
+     * `pwrite()`). these never touch the shared `FILE*` stream position, so any number of readers
+     * can call `readAt()` on the same object concurrently without locks (unlike `fseek()` +
+     * `fread()`, which mutates the stream even in `const` methods).
+     *
+     * (note that anything written through the `FILE*` stream must be flushed before it is visible
+     * to `readAt()`, since this bypasses stdio buffering.)
+     *
+     * if the file is mapped, reads are just copies out of the mapping.
+     */
+    void readAt(void* buf, bigint len, bigint offset) const;
+    void writeAt(const void* buf, bigint len, bigint offset);
+
+    /**
+     * do all of the positional reads in `reqs` (whose `fd`s are filled in here) at once,
+     * with all of them in flight together (see `utils::async_io::submitAndWait()`).
+     */
+    void readAtBatch(std::vector<utils::async_io::IoReq>& reqs) const;
 };
@@ -1,33 +1,113 @@
 #include "utils/types/ind.h"
 
+#include <algorithm>
 #include <concepts>
-#include <unordered_map>
+#include <span>
+#include <thread>
+#include <vector>
 
+#include "utils/random.h"
 #include "utils/types/basic_types.h"
 #include "utils/types/db/db.h"
 #include "utils/types/range.h"
 #include "utils/types/tuple.h"
 
 
+namespace {
+
+
+// below this many tuples per thread, it's not worth spinning up threads to sort
+constexpr bigint MIN_TUPLES_PER_SORT_THREAD = 1 << 16;
+
+
+/**
+ * stable sort of `vec` by `DbKw` range, split across threads: each thread sorts one chunk, then
+ * adjacent chunks are merged pairwise (also in parallel) until one is left.
+ */
+template <class DbTuple>
+void parallelSortByDbKwRange(std::vector<DbTuple>& vec) {
+    auto compare = [](const DbTuple& dbTuple1, const DbTuple& dbTuple2) {
+        return dbTuple1.getDbKwRange() < dbTuple2.getDbKwRange();
+    };
+
+    bigint threadCount = std::min<bigint>(
+        std::max(1u, std::thread::hardware_concurrency()),
+        vec.size() / MIN_TUPLES_PER_SORT_THREAD
+    );
+    if (threadCount <= 1) {
+        std::stable_sort(vec.begin(), vec.end(), compare);
+        return;
+    }
+
+    std::vector<bigint> chunkStarts;
+    for (bigint i = 0; i <= threadCount; i++) {
+        chunkStarts.push_back(vec.size() * i / threadCount);
+    }
+    std::vector<std::thread> threads;
+    for (bigint i = 0; i < threadCount; i++) {
+        threads.emplace_back([&vec, &compare, &chunkStarts, i] {
+            std::stable_sort(
+                vec.begin() + chunkStarts[i], vec.begin() + chunkStarts[i + 1], compare
+            );
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    // (each round merges chunks `i` and `i + width` into one chunk starting at `i`)
+    for (bigint width = 1; width < threadCount; width *= 2) {
+        threads.clear();
+        for (bigint i = 0; i + width < threadCount; i += 2 * width) {
+            bigint end = chunkStarts[std::min(i + 2 * width, threadCount)];
+            threads.emplace_back([&vec, &compare, &chunkStarts, i, width, end] {
+                std::inplace_merge(
+                    vec.begin() + chunkStarts[i], vec.begin() + chunkStarts[i + width],
+                    vec.begin() + end, compare
+                );
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+}
+
+
+} // anonymous namespace
+
+
 //------------------------------------------------------------------------------
 // constructors/destructors
 
 
 template <IsDbTuple DbTuple>
 Ind<DbTuple>::Ind(const Db<DbTuple>& db, bool shouldShuffleKwLists) {
+    this->dbTuples.reserve(db.size());
     for (const DbTuple& dbTuple : db) {
-        Range<DbKw> dbKwRange = dbTuple.getDbKwRange();
-        if (!this->contains(dbKwRange)) {
-            (*this)[dbKwRange] = Db<DbTuple> {dbTuple};
-        } else {
-            (*this)[dbKwRange].push_back(dbTuple);
+        this->dbTuples.push_back(dbTuple);
+    }
+
+    // group tuples by keyword (stably, so that each keyword's tuples keep their order from `db`)
+    ::parallelSortByDbKwRange(this->dbTuples);
+
+    // record where each keyword's slice starts
+    bigint dbSize = this->dbTuples.size();
+    for (bigint i = 0; i < dbSize; i++) {
+        Range<DbKw> dbKwRange = this->dbTuples[i].getDbKwRange();
+        if (this->dbKwRanges.empty() || dbKwRange != this->dbKwRanges.back()) {
+            this->dbKwRanges.push_back(dbKwRange);
+            this->dbKwOffsets.push_back(i);
         }
     }
+    this->dbKwOffsets.push_back(dbSize);
 
     if (shouldShuffleKwLists) {
-        for (auto& pair : *this) {
-            Db<DbTuple>& dbKwList = pair.second;
-            dbKwList.shuffle();
+        for (bigint i = 0; i < (bigint)this->dbKwRanges.size(); i++) {
+            std::shuffle(
+                this->dbTuples.begin() + this->dbKwOffsets[i],
+                this->dbTuples.begin() + this->dbKwOffsets[i + 1], utils::random::RNG
+            );
         }
     }
 }
@@ -37,33 +117,28 @@ Ind<DbTuple>::Ind(const Db<DbTuple>& db, bool shouldShuffleKwLists) {
 // interface
 
 
-template <IsDbTuple DbTuple>
-Ind<DbTuple>::Iter Ind<DbTuple>::find(const KeyType& key) {
-    return this->map.find(key);
-}
-
-
-template <IsDbTuple DbTuple>
-Ind<DbTuple>::ConstIter Ind<DbTuple>::find(const KeyType& key) const {
-    return this->map.find(key);
-}
-
-
 template <IsDbTuple DbTuple>
 bool Ind<DbTuple>::contains(const KeyType& key) const {
-    return this->map.contains(key);
+    return std::binary_search(this->dbKwRanges.begin(), this->dbKwRanges.end(), key);
 }
 
 
 template <IsDbTuple DbTuple>
-Ind<DbTuple>::ValType& Ind<DbTuple>::operator [](const KeyType& key) {
-    return this->map[key];
+Ind<DbTuple>::ValType Ind<DbTuple>::operator [](const KeyType& key) const {
+    auto iter = std::lower_bound(this->dbKwRanges.begin(), this->dbKwRanges.end(), key);
+    if (iter == this->dbKwRanges.end() || *iter != key) {
+        return ValType {};
+    }
+
+    return this->getDbKwList(iter - this->dbKwRanges.begin());
 }
 
 
 template <IsDbTuple DbTuple>
-const Ind<DbTuple>::ValType& Ind<DbTuple>::operator [](const KeyType& key) const {
-    return this->map.at(key);
+Ind<DbTuple>::ValType Ind<DbTuple>::getDbKwList(bigint dbKwIndex) const {
+    bigint start = this->dbKwOffsets[dbKwIndex];
+    bigint end = this->dbKwOffsets[dbKwIndex + 1];
+    return ValType(this->dbTuples.data() + start, end - start);
 }
 
 
@@ -1,7 +1,8 @@
 #pragma once
 
 #include <concepts>
-#include <unordered_map>
+#include <span>
+#include <vector>
 
 #include "utils/types/basic_types.h"
 #include "utils/types/db/db.h"
@@ -9,15 +10,18 @@
 #include "utils/types/tuple.h"
 
 
+/**
+ * (plaintext) index of each keyword to the tuples with that keyword, in compressed sparse row
+ * form: all tuples in one array sorted by keyword (so each keyword's tuples are a contiguous
+ * slice of it), the distinct keywords in sorted order, and the offset of each keyword's slice.
+ * building it is just one (parallel) sort, with no per-keyword allocations.
+ */
 template <IsDbTuple DbTuple = Tuple<>>
 class Ind {
 private:
-    using DbKw      = typename DbTuple::DbKwType;
-    using KeyType   = Range<DbKw>;
-    using ValType   = Db<DbTuple>;
-    using InnerType = std::unordered_map<KeyType, ValType>;
-    using Iter      = InnerType::iterator;
-    using ConstIter = InnerType::const_iterator;
+    using DbKw    = typename DbTuple::DbKwType;
+    using KeyType = Range<DbKw>;
+    using ValType = std::span<const DbTuple>;
 
 public:
     //--------------------------------------------------------------------------
@@ -28,35 +32,25 @@ public:
     //--------------------------------------------------------------------------
     // interface
 
-    Iter find(const KeyType& key);
-    ConstIter find(const KeyType& key) const;
     bool contains(const KeyType& key) const;
 
-    ValType& operator [](const KeyType& key);
-    const ValType& operator [](const KeyType& key) const;
+    /**
+     * returns: view of the tuples with keyword `key` (empty if there are none), which stays valid
+     * for as long as this `Ind` does.
+     */
+    ValType operator [](const KeyType& key) const;
 
-private:
-    InnerType map;
-
-    //--------------------------------------------------------------------------
-    // iterator
+    /**
+     * the distinct keywords (i.e. W) in sorted order, so that each keyword's list can then be
+     * fetched by its index in here with `getDbKwList()` without any lookups.
+     */
+    const std::vector<KeyType>& getDbKwRanges() const { return this->dbKwRanges; }
+    ValType getDbKwList(bigint dbKwIndex) const;
 
-public:
-    // non-const iterators
-    Iter begin() {
-        return this->map.begin();
-    }
-
-    Iter end() {
-        return this->map.end();
-    }
-
-    // const iterators
-    ConstIter begin() const {
-        return this->map.begin();
-    }
-
-    ConstIter end() const {
-        return this->map.end();
-    }
+private:
+    std::vector<DbTuple> dbTuples;
+    std::vector<KeyType> dbKwRanges;
+    // the tuples with keyword `this->dbKwRanges[i]` are at indices `this->dbKwOffsets[i]`
+    // (inclusive) to `this->dbKwOffsets[i + 1]` (exclusive) of `this->dbTuples`
+    std::vector<bigint> dbKwOffsets;
 };
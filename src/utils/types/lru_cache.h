@@ -0,0 +1,115 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "utils/types/basic_types.h"
+
+
+/**
+ * least recently used cache from `Key`s to lists of `T`s (e.g. the decrypted results of an SRC
+ * node), bounded by the total number of `T`s held across all entries rather than the number of
+ * entries, and safe for concurrent searchers. lists longer than the whole capacity are never
+ * cached, and a capacity of `0` turns the cache off entirely.
+ */
+template <class Key, class T>
+class LruCache {
+public:
+    //--------------------------------------------------------------------------
+    // constructors/destructors
+
+    LruCache(bigint capacity) : capacity(capacity) {}
+
+    //--------------------------------------------------------------------------
+    // the big five
+
+    // destructor
+    ~LruCache() = default;
+
+    // copy constructor
+    LruCache(const LruCache& other) = delete;
+
+    // copy assignment operator
+    LruCache& operator =(const LruCache& other) = delete;
+
+    // move constructor
+    LruCache(LruCache&& other) noexcept = delete;
+
+    // move assignment operator
+    LruCache& operator =(LruCache&& other) noexcept = delete;
+
+    //--------------------------------------------------------------------------
+    // interface
+
+    bool isEnabled() const { return this->capacity > 0; }
+
+    /**
+     * look up `key`, marking it as the most recently used entry if it's there.
+     *
+     * returns:
+     *     - `true` if `key` is cached (and its list is copied into `ret`).
+     *     - `false` if `key` is not cached.
+     */
+    bool get(const Key& key, std::vector<T>& ret) {
+        if (!this->isEnabled()) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto entryIt = this->entryIts.find(key);
+        if (entryIt == this->entryIts.end()) {
+            return false;
+        }
+        this->entries.splice(this->entries.begin(), this->entries, entryIt->second);
+        ret = entryIt->second->second;
+        return true;
+    }
+
+    /**
+     * cache `vals` under `key` as the most recently used entry, evicting least recently used
+     * entries until everything fits.
+     */
+    void put(const Key& key, const std::vector<T>& vals) {
+        if (!this->isEnabled() || (bigint)vals.size() > this->capacity) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto entryIt = this->entryIts.find(key);
+        if (entryIt != this->entryIts.end()) {
+            this->size -= entryIt->second->second.size();
+            this->entries.erase(entryIt->second);
+            this->entryIts.erase(entryIt);
+        }
+
+        this->entries.emplace_front(key, vals);
+        this->entryIts[key] = this->entries.begin();
+        this->size += vals.size();
+        while (this->size > this->capacity) {
+            const std::pair<Key, std::vector<T>>& lruEntry = this->entries.back();
+            this->size -= lruEntry.second.size();
+            this->entryIts.erase(lruEntry.first);
+            this->entries.pop_back();
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->entries.clear();
+        this->entryIts.clear();
+        this->size = 0;
+    }
+
+private:
+    bigint capacity;
+    // total number of `T`s currently cached
+    bigint size = 0;
+
+    // most recently used first
+    std::list<std::pair<Key, std::vector<T>>> entries;
+    std::unordered_map<Key, typename std::list<std::pair<Key, std::vector<T>>>::iterator> entryIts;
+    std::mutex mutex;
+};
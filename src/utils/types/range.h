@@ -8,6 +8,7 @@
 #include <string>
 #include <utility>
 
+#include "utils/hash.h"
 #include "utils/types/basic_types.h"
 #include "utils/types/ustring.h"
 
@@ -54,7 +55,7 @@ private:
 template <std::integral T>
 struct std::hash<Range<T>> {
     inline std::size_t operator ()(const Range<T>& range) const noexcept {
-        return std::hash<std::string>{}(range.toStr());
+        return utils::hash::hashInts(range.first, range.second);
     }
 };
 
@@ -1,13 +1,13 @@
 #include "utils/types/tdag.h"
 
 #include <concepts>
-#include <cmath>
 #include <cstdlib>
 #include <deque>
 #include <list>
 #include <unordered_set>
 #include <vector>
 
+#include "utils/int_math.h"
 #include "utils/types/basic_types.h"
 #include "utils/types/db/db.h"
 #include "utils/types/range.h"
@@ -332,12 +332,16 @@ bigint calcTdagTupleCount(bigint leafCount) {
     // = (m - i)(2n) - (2^m + 2^(m-1) + ... + 2^(i+1))
     // = (m - i)(2n) - ((1 - 0.5^(m-i)) 2^m / 0.5)            (sum of geometric series)
     // = (m - i)(2n) - (1 - 2^(i-m)) 2^(m+1)
+    // = (m - i)(2n) - (2^(m+1) - 2^(i+1))
     //
     // so here we are just calculating the case where i is 0 (so number of tuples
     // above the bottommost level) and then adding the number of leaves
-    bigint topLevelNum = std::log2(leafCount);
+    if (leafCount <= 0) {
+        return 0;
+    }
+    bigint topLevelNum = ::utils::int_math::floorLog2(leafCount);
     return topLevelNum * (2 * leafCount)
-        - (1 - std::pow(2, -topLevelNum)) * std::pow(2, topLevelNum + 1)
+        - (::utils::int_math::pow2(topLevelNum + 1) - 2)
         + leafCount;
 }
 
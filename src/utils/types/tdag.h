@@ -40,6 +40,12 @@ public:
      */
     std::list<Range<T>> getLeafAncestors(const Range<T>& target) const;
 
+    /**
+     * returns: the range covered by this node (for the root, this is the leaf range it was
+     * built from, which fully determines the TDAG).
+     */
+    Range<T> getRange() const { return this->range; }
+
     template <std::integral T2>
     friend std::ostream& operator <<(std::ostream& os, TdagNode<T2>* node);
 
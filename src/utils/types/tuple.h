@@ -9,6 +9,9 @@
 #include <unordered_map>
 #include <utility>
 
+#include "config.h"
+
+#include "utils/hash.h"
 #include "utils/types/basic_types.h"
 #include "utils/types/range.h"
 #include "utils/types/ustring.h"
@@ -41,6 +44,8 @@ public:
     Range<DbKw> getDbKwRange() const { return this->dbKwRange; }
 
     // `toStr()` should be the most compact possible unambiguous encoding, for efficient storage
+    // (and children should declare its max length as `MAX_STR_LEN`, which sizes the entries of
+    // encrypted indexes holding them; see `DbTupleEncIndLayout`)
     virtual std::string toStr() const = 0;
     virtual std::string toPrintableStr() const = 0;
     ustring toUstr() const;
@@ -79,6 +84,9 @@ concept IsDbTuple = requires(T t) {
 template <class DbKw = Kw>
 class Tuple : public IDbTuple<std::tuple<Id, Kw, Op>, DbKw> {
 public:
+    // (`id,kw[op]dbKw-dbKw`, i.e. 4 values and 3 separators)
+    inline static constexpr int MAX_STR_LEN = 4 * config::MAX_VALUE_DIGITS + 3;
+
     inline static const Tuple DUMMY(const Range<DbKw>& dbKwRange) {
         return Tuple {::DUMMY, ::DUMMY, Op::DUMMY, dbKwRange};
     }
@@ -112,7 +120,10 @@ private:
 template <class DbKw>
 struct std::hash<Tuple<DbKw>> {
     inline std::size_t operator ()(const Tuple<DbKw>& tuple) const noexcept {
-        return std::hash<std::string>{}(tuple.toStr());
+        Range<DbKw> dbKwRange = tuple.getDbKwRange();
+        return utils::hash::hashInts(
+            tuple.getId(), tuple.getKw(), tuple.getOp(), dbKwRange.first, dbKwRange.second
+        );
     }
 };
 
@@ -124,6 +135,9 @@ struct std::hash<Tuple<DbKw>> {
 
 class SrcIDb1Tuple : public IDbTuple<std::pair<Kw, Range<IdAlias>>, Kw> {
 public:
+    // (`kw,idAlias-idAlias,kw-kw`, i.e. 5 values and 4 separators)
+    inline static constexpr int MAX_STR_LEN = 5 * config::MAX_VALUE_DIGITS + 4;
+
     inline static const SrcIDb1Tuple DUMMY(const Range<Kw>& kwRange) {
         return SrcIDb1Tuple {::DUMMY, Range<IdAlias>::DUMMY(), kwRange};
     }
@@ -150,3 +164,17 @@ private:
     static const std::string REGEX_STR;
     static const std::regex REGEX;
 };
+
+
+// specialize `std::hash` for `SrcIDb1Tuple` so that they can be used as keys for `std::unordered_*`
+template <>
+struct std::hash<SrcIDb1Tuple> {
+    inline std::size_t operator ()(const SrcIDb1Tuple& tuple) const noexcept {
+        Range<IdAlias> idAliasRange = tuple.getIdAliasRange();
+        Range<Kw> dbKwRange = tuple.getDbKwRange();
+        return utils::hash::hashInts(
+            tuple.getKw(), idAliasRange.first, idAliasRange.second, dbKwRange.first,
+            dbKwRange.second
+        );
+    }
+};
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <string>
 
+#include "utils/hash.h"
 #include "utils/types/basic_types.h"
 
 
@@ -33,6 +34,6 @@ std::ostream& operator <<(std::ostream& os, const ustring& ustr);
 template <>
 struct std::hash<ustring> {
     inline std::size_t operator ()(const ustring& ustr) const noexcept {
-        return std::hash<std::string>{}(utils::ustr::toStr(ustr));
+        return utils::hash::hashBytes(ustr.data(), ustr.length());
     }
 };